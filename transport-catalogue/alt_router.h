@@ -0,0 +1,331 @@
+#pragma once
+
+#include "graph.h"
+#include "monotone_queue.h"
+#include "search_workspace.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Поиск кратчайшего пути A* с нижними оценками по ориентирам (ALT: A*, landmarks, triangle inequality).
+// Предподсчёт выбирает до landmark_count вершин-ориентиров, каждый следующий — как можно дальше от уже выбранных,
+// и хранит расстояния от каждого ориентира L до всех вершин и от всех вершин до него. По неравенству треугольника
+// dist(v, t) >= dist(L, t) - dist(L, v) и dist(v, t) >= dist(v, L) - dist(t, L), поэтому поиск идёт в сторону цели.
+// Память линейна по числу вершин и рёбер, предподсчёт — 3 * landmark_count обходов графа.
+// При landmark_count == 0 это обычный алгоритм Дейкстры.
+// Для целых весов оценки точны и согласованы, поэтому ключи очереди не убывают и она может быть поразрядной кучей.
+// Рабочая память запроса своя у каждого потока и переиспользуется, поэтому BuildRoute можно вызывать из разных потоков
+template <typename Weight>
+class AltRouter {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    AltRouter(const Graph& graph, size_t landmark_count);
+
+    // Копирует ориентиры other для копии его графа
+    AltRouter(const Graph& graph, const AltRouter& other);
+
+    struct RouteInfo {
+        Weight weight;
+        std::vector<EdgeId> edges;
+    };
+
+    // settled_count, если задан, получает число вершин, извлечённых из очереди
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to, size_t* settled_count = nullptr) const;
+
+    // Пересчитывает расстояния до ориентиров после изменения весов рёбер. Набор рёбер должен остаться прежним
+    void UpdateEdgeWeights();
+
+    size_t GetLandmarkCount() const;
+
+    // Байты, занятые расстояниями до ориентиров и обратными списками смежности
+    size_t GetMemoryUsage() const;
+
+private:
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr Weight UNREACHABLE = std::numeric_limits<Weight>::max();
+
+    using Workspace = SearchWorkspace<Weight, std::pair<Weight, VertexId>>;
+
+    static Workspace& GetWorkspace();
+
+    // Расстояния от source до всех вершин; при is_reverse — от всех вершин до source
+    std::vector<Weight> ComputeDistances(VertexId source, bool is_reverse) const;
+
+    void BuildReverseIncidence();
+
+    void SelectLandmarks(size_t landmark_count);
+
+    void ComputeLandmarkDistances();
+
+    // Нижняя оценка расстояния от vertex до to; UNREACHABLE, если по ориентирам видно, что to из vertex недостижима
+    Weight GetLowerBound(VertexId vertex, VertexId to) const;
+
+    const Graph& graph_;
+    std::vector<VertexId> landmarks_;
+    // Расстояния по вершинам подряд: forward_[v * landmarks_.size() + l] = dist(landmarks_[l], v),
+    // backward_[v * landmarks_.size() + l] = dist(v, landmarks_[l])
+    std::vector<Weight> forward_;
+    std::vector<Weight> backward_;
+    // Входящие рёбра вершины v: reverse_edges_[reverse_begin_[v]..reverse_begin_[v + 1])
+    std::vector<size_t> reverse_begin_;
+    std::vector<EdgeId> reverse_edges_;
+};
+
+template <typename Weight>
+AltRouter<Weight>::AltRouter(const Graph& graph, size_t landmark_count)
+    : graph_(graph)
+{
+    for (EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+        if (graph_.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+    BuildReverseIncidence();
+    SelectLandmarks(landmark_count);
+    ComputeLandmarkDistances();
+}
+
+template <typename Weight>
+AltRouter<Weight>::AltRouter(const Graph& graph, const AltRouter& other)
+    : graph_(graph)
+    , landmarks_(other.landmarks_)
+    , forward_(other.forward_)
+    , backward_(other.backward_)
+    , reverse_begin_(other.reverse_begin_)
+    , reverse_edges_(other.reverse_edges_)
+{
+}
+
+template <typename Weight>
+void AltRouter<Weight>::BuildReverseIncidence() {
+    const size_t vertex_count = graph_.GetVertexCount();
+    reverse_begin_.assign(vertex_count + 1, 0);
+    for (EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+        ++reverse_begin_[graph_.GetEdge(edge_id).to + 1];
+    }
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        reverse_begin_[vertex + 1] += reverse_begin_[vertex];
+    }
+    reverse_edges_.resize(graph_.GetEdgeCount());
+    std::vector<size_t> next = reverse_begin_;
+    for (EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+        reverse_edges_[next[graph_.GetEdge(edge_id).to]++] = edge_id;
+    }
+}
+
+template <typename Weight>
+std::vector<Weight> AltRouter<Weight>::ComputeDistances(VertexId source, bool is_reverse) const {
+    std::vector<Weight> distances(graph_.GetVertexCount(), UNREACHABLE);
+    MonotoneQueue<Weight, VertexId> queue;
+    distances[source] = ZERO_WEIGHT;
+    queue.Push(ZERO_WEIGHT, source);
+    const auto relax = [&](VertexId vertex, Weight distance) {
+        if (distance < distances[vertex]) {
+            distances[vertex] = distance;
+            queue.Push(distance, vertex);
+        }
+    };
+    while (!queue.IsEmpty()) {
+        const auto [key, vertex] = queue.Pop();
+        const Weight distance = static_cast<Weight>(key);
+        if (distance > distances[vertex]) {
+            continue;
+        }
+        if (is_reverse) {
+            for (size_t i = reverse_begin_[vertex]; i < reverse_begin_[vertex + 1]; ++i) {
+                const auto& edge = graph_.GetEdge(reverse_edges_[i]);
+                relax(edge.from, distance + edge.weight);
+            }
+        } else {
+            for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                relax(edge.to, distance + edge.weight);
+            }
+        }
+    }
+    return distances;
+}
+
+template <typename Weight>
+void AltRouter<Weight>::SelectLandmarks(size_t landmark_count) {
+    // Вершины без рёбер, кроме одного, — например, остановки без маршрутов — ничего не дают поиску
+    const size_t vertex_count = graph_.GetVertexCount();
+    std::vector<bool> is_eligible(vertex_count);
+    VertexId start = vertex_count;
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        const size_t degree = graph_.GetIncidentEdges(vertex).end() - graph_.GetIncidentEdges(vertex).begin()
+                              + reverse_begin_[vertex + 1] - reverse_begin_[vertex];
+        is_eligible[vertex] = degree >= 2;
+        if (is_eligible[vertex] && start == vertex_count) {
+            start = vertex;
+        }
+    }
+    if (start == vertex_count || landmark_count == 0) {
+        return;
+    }
+
+    // Первый ориентир — самая далёкая от произвольной вершины, каждый следующий — самая далёкая от выбранных.
+    // Вершины, недостижимые из выбранных ориентиров, идут первыми: так ориентир получает каждая часть графа
+    std::vector<Weight> nearest = ComputeDistances(start, false);
+    while (landmarks_.size() < landmark_count) {
+        VertexId farthest = vertex_count;
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            if (is_eligible[vertex] && nearest[vertex] > ZERO_WEIGHT
+                && (farthest == vertex_count || nearest[vertex] > nearest[farthest])) {
+                farthest = vertex;
+            }
+        }
+        if (farthest == vertex_count) {
+            break;
+        }
+        landmarks_.push_back(farthest);
+        const std::vector<Weight> distances = ComputeDistances(farthest, false);
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            nearest[vertex] = std::min(nearest[vertex], distances[vertex]);
+        }
+        nearest[farthest] = ZERO_WEIGHT;
+    }
+}
+
+template <typename Weight>
+void AltRouter<Weight>::ComputeLandmarkDistances() {
+    const size_t landmark_count = landmarks_.size();
+    const size_t vertex_count = graph_.GetVertexCount();
+    forward_.assign(vertex_count * landmark_count, UNREACHABLE);
+    backward_.assign(vertex_count * landmark_count, UNREACHABLE);
+    for (size_t landmark = 0; landmark < landmark_count; ++landmark) {
+        const std::vector<Weight> from_landmark = ComputeDistances(landmarks_[landmark], false);
+        const std::vector<Weight> to_landmark = ComputeDistances(landmarks_[landmark], true);
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            forward_[vertex * landmark_count + landmark] = from_landmark[vertex];
+            backward_[vertex * landmark_count + landmark] = to_landmark[vertex];
+        }
+    }
+}
+
+template <typename Weight>
+void AltRouter<Weight>::UpdateEdgeWeights() {
+    for (EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+        if (graph_.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+    ComputeLandmarkDistances();
+}
+
+template <typename Weight>
+Weight AltRouter<Weight>::GetLowerBound(VertexId vertex, VertexId to) const {
+    const size_t landmark_count = landmarks_.size();
+    const Weight* forward_vertex = forward_.data() + vertex * landmark_count;
+    const Weight* forward_to = forward_.data() + to * landmark_count;
+    const Weight* backward_vertex = backward_.data() + vertex * landmark_count;
+    const Weight* backward_to = backward_.data() + to * landmark_count;
+
+    Weight bound = ZERO_WEIGHT;
+    for (size_t landmark = 0; landmark < landmark_count; ++landmark) {
+        // Если ориентир достигает vertex, но не to, или to достигает ориентира, а vertex нет, пути из vertex в to нет
+        if (forward_vertex[landmark] != UNREACHABLE) {
+            if (forward_to[landmark] == UNREACHABLE) {
+                return UNREACHABLE;
+            }
+            if (forward_to[landmark] > forward_vertex[landmark]) {
+                bound = std::max(bound, forward_to[landmark] - forward_vertex[landmark]);
+            }
+        }
+        if (backward_to[landmark] != UNREACHABLE) {
+            if (backward_vertex[landmark] == UNREACHABLE) {
+                return UNREACHABLE;
+            }
+            if (backward_vertex[landmark] > backward_to[landmark]) {
+                bound = std::max(bound, backward_vertex[landmark] - backward_to[landmark]);
+            }
+        }
+    }
+    return bound;
+}
+
+template <typename Weight>
+std::optional<typename AltRouter<Weight>::RouteInfo> AltRouter<Weight>::BuildRoute(VertexId from, VertexId to,
+                                                                                   size_t* settled_count) const {
+    if (settled_count) {
+        *settled_count = 0;
+    }
+    if (GetLowerBound(from, to) == UNREACHABLE) {
+        return std::nullopt;
+    }
+
+    // Ключ очереди — расстояние от from плюс нижняя оценка до to; запись устарела, если расстояние уже меньше.
+    // Оценка считается один раз для вершины и хранится в записи рабочей памяти
+    Workspace& workspace = GetWorkspace();
+    workspace.Reset(graph_.GetVertexCount());
+    auto& queue = workspace.GetQueue();
+    workspace.Get(from).distance = ZERO_WEIGHT;
+    queue.Push(ZERO_WEIGHT, {ZERO_WEIGHT, from});
+    while (!queue.IsEmpty()) {
+        const auto [distance, vertex] = queue.Pop().second;
+        if (distance > workspace.Get(vertex).distance) {
+            continue;
+        }
+        if (settled_count) {
+            ++*settled_count;
+        }
+        if (vertex == to) {
+            break;
+        }
+        for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            const Weight next_distance = distance + edge.weight;
+            auto& next = workspace.Get(edge.to);
+            if (next_distance >= next.distance || next.is_pruned) {
+                continue;
+            }
+            if (next.bound == UNREACHABLE) {
+                next.bound = GetLowerBound(edge.to, to);
+                if (next.bound == UNREACHABLE) {
+                    next.is_pruned = true;
+                    continue;
+                }
+            }
+            next.distance = next_distance;
+            next.prev_edge = edge_id;
+            queue.Push(next_distance + next.bound, {next_distance, edge.to});
+        }
+    }
+
+    if (workspace.Get(to).distance == UNREACHABLE) {
+        return std::nullopt;
+    }
+    RouteInfo route{workspace.Get(to).distance, {}};
+    for (VertexId vertex = to; vertex != from; vertex = graph_.GetEdge(route.edges.back()).from) {
+        route.edges.push_back(workspace.Get(vertex).prev_edge);
+    }
+    std::reverse(route.edges.begin(), route.edges.end());
+    return route;
+}
+
+template <typename Weight>
+typename AltRouter<Weight>::Workspace& AltRouter<Weight>::GetWorkspace() {
+    thread_local Workspace workspace;
+    return workspace;
+}
+
+template <typename Weight>
+size_t AltRouter<Weight>::GetLandmarkCount() const {
+    return landmarks_.size();
+}
+
+template <typename Weight>
+size_t AltRouter<Weight>::GetMemoryUsage() const {
+    return landmarks_.capacity() * sizeof(VertexId) + (forward_.capacity() + backward_.capacity()) * sizeof(Weight)
+           + reverse_begin_.capacity() * sizeof(size_t) + reverse_edges_.capacity() * sizeof(EdgeId);
+}
+}  // namespace graph
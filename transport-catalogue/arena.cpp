@@ -0,0 +1,132 @@
+#include "arena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+#include <sys/mman.h>
+
+namespace catalogue
+{
+    namespace
+    {
+        constexpr size_t MAX_CHUNK_SIZE = size_t{1} << 30;
+
+        size_t RoundUp(size_t value, size_t alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        void *MapAnonymous(size_t size, int extra_flags)
+        {
+            void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | extra_flags, -1, 0);
+            return data == MAP_FAILED ? nullptr : data;
+        }
+    }
+
+    ArenaResource::ArenaResource(bool use_huge_pages)
+        : use_huge_pages_(use_huge_pages) {}
+
+    ArenaResource::~ArenaResource()
+    {
+        for (const Chunk &chunk : chunks_)
+        {
+            munmap(chunk.mapping, chunk.mapping_size);
+        }
+    }
+
+    bool ArenaResource::IsUsingHugePages() const
+    {
+        return use_huge_pages_;
+    }
+
+    size_t ArenaResource::GetAllocatedBytes() const
+    {
+        return allocated_bytes_;
+    }
+
+    size_t ArenaResource::GetReservedBytes() const
+    {
+        size_t bytes = 0;
+        for (const Chunk &chunk : chunks_)
+        {
+            bytes += chunk.size;
+        }
+        return bytes;
+    }
+
+    size_t ArenaResource::GetWastedBytes() const
+    {
+        return wasted_bytes_;
+    }
+
+    PageBacking ArenaResource::GetPageBacking() const
+    {
+        if (chunks_.empty())
+        {
+            return PageBacking::NORMAL;
+        }
+        PageBacking backing = PageBacking::HUGETLB;
+        for (const Chunk &chunk : chunks_)
+        {
+            backing = std::min(backing, chunk.backing);
+        }
+        return backing;
+    }
+
+    void *ArenaResource::do_allocate(size_t bytes, size_t alignment)
+    {
+        size_t padding = (alignment - reinterpret_cast<uintptr_t>(current_) % alignment) % alignment;
+        if (current_ == nullptr || padding + bytes > remaining_)
+        {
+            // Остаток прежнего куска пропадает: при удвоении размеров это не больше половины памяти арены
+            const Chunk chunk = MapChunk(std::max(next_chunk_size_, RoundUp(bytes + alignment, HUGE_PAGE_SIZE)));
+            chunks_.push_back(chunk);
+            wasted_bytes_ += remaining_;
+            current_ = static_cast<char *>(chunk.data);
+            remaining_ = chunk.size;
+            next_chunk_size_ = std::min(next_chunk_size_ * 2, MAX_CHUNK_SIZE);
+            padding = (alignment - reinterpret_cast<uintptr_t>(current_) % alignment) % alignment;
+        }
+        void *result = current_ + padding;
+        current_ += padding + bytes;
+        remaining_ -= padding + bytes;
+        allocated_bytes_ += bytes;
+        return result;
+    }
+
+    bool ArenaResource::do_is_equal(const std::pmr::memory_resource &other) const noexcept
+    {
+        return this == &other;
+    }
+
+    ArenaResource::Chunk ArenaResource::MapChunk(size_t size) const
+    {
+        if (use_huge_pages_)
+        {
+#ifdef MAP_HUGETLB
+            if (void *data = MapAnonymous(size, MAP_HUGETLB))
+            {
+                return {data, size, data, size, PageBacking::HUGETLB};
+            }
+#endif
+#ifdef MADV_HUGEPAGE
+            // Ядро собирает большую страницу только из выровненных 2 МиБ, поэтому отображение берётся с запасом
+            const size_t mapping_size = size + HUGE_PAGE_SIZE;
+            if (void *mapping = MapAnonymous(mapping_size, 0))
+            {
+                const uintptr_t begin = reinterpret_cast<uintptr_t>(mapping);
+                void *data = reinterpret_cast<void *>(RoundUp(begin, HUGE_PAGE_SIZE));
+                const PageBacking backing = madvise(data, size, MADV_HUGEPAGE) == 0 ? PageBacking::TRANSPARENT_HUGE : PageBacking::NORMAL;
+                return {data, size, mapping, mapping_size, backing};
+            }
+#endif
+        }
+        void *data = MapAnonymous(size, 0);
+        if (data == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        return {data, size, data, size, PageBacking::NORMAL};
+    }
+}
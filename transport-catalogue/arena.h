@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+namespace catalogue
+{
+    // Каким страницам ОС досталась память арены
+    enum class PageBacking
+    {
+        // Обычные страницы по 4 КиБ
+        NORMAL,
+        // Прозрачные большие страницы: ядро собирает их само после madvise(MADV_HUGEPAGE)
+        TRANSPARENT_HUGE,
+        // Зарезервированные большие страницы по 2 МиБ (MAP_HUGETLB, vm.nr_hugepages)
+        HUGETLB,
+    };
+
+    /*
+     * Монотонная арена для данных, которые строятся один раз, а потом только читаются вразнобой:
+     * таблицы маршрутов и рёбер графа. Память берётся у ОС кусками от 2 МиБ и выдаётся подряд,
+     * освобождается вся сразу при разрушении арены, deallocate ничего не делает.
+     * С use_huge_pages куски сначала запрашиваются из зарезервированных больших страниц, затем
+     * как обычная память с madvise(MADV_HUGEPAGE), выровненная на 2 МиБ; если ни то ни другое
+     * недоступно, остаются обычные страницы. На больших таблицах это сокращает промахи TLB.
+     * Выделение не потокобезопасно: арена заполняется при построении, а читать данные можно из любых потоков
+     */
+    class ArenaResource : public std::pmr::memory_resource
+    {
+    public:
+        static constexpr size_t HUGE_PAGE_SIZE = size_t{2} << 20;
+
+        explicit ArenaResource(bool use_huge_pages);
+        ~ArenaResource() override;
+
+        ArenaResource(const ArenaResource &) = delete;
+        ArenaResource &operator=(const ArenaResource &) = delete;
+
+        bool IsUsingHugePages() const;
+
+        // Байты, выданные пользователям арены
+        size_t GetAllocatedBytes() const;
+
+        // Байты, полученные у ОС. Страницы, которых ещё не касались, память не занимают
+        size_t GetReservedBytes() const;
+
+        // Остатки прежних кусков, которые уже не будут выданы
+        size_t GetWastedBytes() const;
+
+        // Самые мелкие страницы среди кусков арены; NORMAL, если кусков ещё нет
+        PageBacking GetPageBacking() const;
+
+    private:
+        struct Chunk
+        {
+            void *data;
+            size_t size;
+            // Начало отображения mmap и его длина: при выравнивании на 2 МиБ они шире куска
+            void *mapping;
+            size_t mapping_size;
+            PageBacking backing;
+        };
+
+        void *do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void *, size_t, size_t) override {}
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+        Chunk MapChunk(size_t size) const;
+
+        bool use_huge_pages_;
+        std::vector<Chunk> chunks_;
+        // Свободный остаток последнего куска
+        char *current_ = nullptr;
+        size_t remaining_ = 0;
+        size_t allocated_bytes_ = 0;
+        size_t wasted_bytes_ = 0;
+        // Размер следующего куска удваивается до 1 ГиБ, чтобы кусков было немного
+        size_t next_chunk_size_ = HUGE_PAGE_SIZE;
+    };
+}
@@ -0,0 +1,146 @@
+// Сравнение поиска A* по ориентирам (AltRouter) с алгоритмом Дейкстры на графе синтетического города:
+// время предподсчёта, память, среднее число просмотренных вершин и время на запрос. Оба поиска замеряются
+// и на дробных весах в минутах с двоичной кучей, и на целых весах с поразрядной кучей.
+// Сборка: g++ -std=c++17 -O2 -pthread -I.. alt_router.cpp city_generator.cpp ../json.cpp ../json_builder.cpp ../json_reader.cpp
+//         ../transport_catalogue.cpp ../transport_router.cpp ../arena.cpp ../raptor.cpp ../name_index.cpp ../domain.cpp ../geo.cpp
+//         ../map_renderer.cpp ../svg.cpp ../spatial_index.cpp ../request_handler.cpp ../thread_pool.cpp ../metrics.cpp ../histogram.cpp -o alt_router
+// Запуск: ./alt_router [параметры города, см. make_city] [--landmarks 16] [--queries 1000]
+
+#include "alt_router.h"
+#include "city_generator.h"
+#include "json_reader.h"
+#include "transport_router.h"
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace catalogue;
+using namespace std::literals;
+
+namespace
+{
+    struct QueryStats
+    {
+        double settled = 0.0;
+        double microseconds = 0.0;
+        size_t found = 0;
+    };
+
+    template <typename Weight>
+    QueryStats RunQueries(const graph::AltRouter<Weight> &router, const std::vector<std::pair<graph::VertexId, graph::VertexId>> &queries,
+                          std::vector<double> &weights, double units_per_minute = 1.0)
+    {
+        QueryStats stats;
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < queries.size(); ++i)
+        {
+            size_t settled = 0;
+            const auto route = router.BuildRoute(queries[i].first, queries[i].second, &settled);
+            stats.settled += settled;
+            stats.found += route.has_value();
+            weights[i] = route ? route->weight / units_per_minute : -1.0;
+        }
+        stats.microseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / queries.size();
+        stats.settled /= queries.size();
+        return stats;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    bench::CityParams params;
+    size_t landmark_count = 16;
+    size_t query_count = 1000;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        const std::string_view option = argv[i];
+        if (option == "--landmarks"sv)
+        {
+            landmark_count = std::stoul(argv[i + 1]);
+        }
+        else if (option == "--queries"sv)
+        {
+            query_count = std::max<size_t>(1, std::stoul(argv[i + 1]));
+        }
+        else if (!bench::ParseCityOption(option, argv[i + 1], params))
+        {
+            std::cerr << "Unknown option: "sv << option << std::endl;
+            return 1;
+        }
+    }
+
+    TransportCatalogue catalogue;
+    std::vector<json::StatRequests> stat_requests;
+    renderer::RenderSettings rend_sett;
+    router::RouterSettings rout_sett{};
+    json::ParseRequests(bench::GenerateCity(params), catalogue, stat_requests, rend_sett, rout_sett);
+    // Ориентиры TransportRouter не нужны: замеряется только построенный им граф
+    rout_sett.engine = router::RouterEngine::ALT;
+    rout_sett.landmark_count = 0;
+    const router::TransportRouter transport_router(rout_sett, catalogue);
+    const auto &graph = transport_router.GetGraph();
+
+    // Пары остановок: из вершины ожидания одной в вершину ожидания другой, как в GetShortestRoute
+    std::mt19937 random(params.seed);
+    std::uniform_int_distribution<graph::VertexId> stop(0, catalogue.GetStopCount() - 1);
+    std::vector<std::pair<graph::VertexId, graph::VertexId>> queries;
+    for (size_t i = 0; i < query_count; ++i)
+    {
+        queries.push_back({stop(random) * 2, stop(random) * 2});
+    }
+
+    // Те же рёбра с весами в единицах, как у TransportRouter с integer_weights
+    const double units_per_minute = transport_router.WEIGHT_UNITS_PER_MINUTE;
+    graph::DirectedWeightedGraph<int64_t> integer_graph(graph.GetVertexCount());
+    for (graph::EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id)
+    {
+        const auto &edge = graph.GetEdge(edge_id);
+        integer_graph.AddEdge({edge.from, edge.to, std::llround(edge.weight * units_per_minute), edge.span_count, edge.name});
+    }
+
+    const graph::AltRouter<double> dijkstra(graph, 0);
+    const auto build_start = std::chrono::steady_clock::now();
+    const graph::AltRouter<double> alt(graph, landmark_count);
+    const double build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - build_start).count();
+    const graph::AltRouter<int64_t> integer_dijkstra(integer_graph, 0);
+    const auto integer_build_start = std::chrono::steady_clock::now();
+    const graph::AltRouter<int64_t> integer_alt(integer_graph, landmark_count);
+    const double integer_build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - integer_build_start).count();
+
+    std::vector<double> dijkstra_weights(queries.size());
+    std::vector<double> alt_weights(queries.size());
+    std::vector<double> integer_dijkstra_weights(queries.size());
+    std::vector<double> integer_alt_weights(queries.size());
+    const QueryStats dijkstra_stats = RunQueries(dijkstra, queries, dijkstra_weights);
+    const QueryStats alt_stats = RunQueries(alt, queries, alt_weights);
+    const QueryStats integer_dijkstra_stats = RunQueries(integer_dijkstra, queries, integer_dijkstra_weights, units_per_minute);
+    const QueryStats integer_alt_stats = RunQueries(integer_alt, queries, integer_alt_weights, units_per_minute);
+
+    // Целые веса округлены до десятой доли секунды на ребро, поэтому сравниваются с допуском на округление
+    size_t mismatches = 0;
+    size_t integer_mismatches = 0;
+    for (size_t i = 0; i < queries.size(); ++i)
+    {
+        mismatches += std::abs(dijkstra_weights[i] - alt_weights[i]) > 1e-9 * std::max(1.0, dijkstra_weights[i]);
+        integer_mismatches += integer_dijkstra_weights[i] != integer_alt_weights[i] || std::abs(integer_dijkstra_weights[i] - dijkstra_weights[i]) > 1.0;
+    }
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "graph: "sv << graph.GetVertexCount() << " vertices, "sv << graph.GetEdgeCount() << " edges\n"sv
+              << "landmarks: "sv << alt.GetLandmarkCount() << ", preprocessing "sv << build_ms << " ms, "sv
+              << alt.GetMemoryUsage() / 1024.0 << " KiB\n"sv
+              << "integer landmarks: preprocessing "sv << integer_build_ms << " ms\n"sv
+              << "queries: "sv << queries.size() << ", found "sv << alt_stats.found << ", mismatches "sv << mismatches
+              << ", integer mismatches "sv << integer_mismatches << '\n'
+              << "dijkstra:         "sv << dijkstra_stats.settled << " settled, "sv << dijkstra_stats.microseconds << " us/query\n"sv
+              << "alt:              "sv << alt_stats.settled << " settled, "sv << alt_stats.microseconds << " us/query\n"sv
+              << "integer dijkstra: "sv << integer_dijkstra_stats.settled << " settled, "sv << integer_dijkstra_stats.microseconds << " us/query\n"sv
+              << "integer alt:      "sv << integer_alt_stats.settled << " settled, "sv << integer_alt_stats.microseconds << " us/query\n"sv
+              << "settled ratio: "sv << dijkstra_stats.settled / std::max(alt_stats.settled, 1.0) << "x\n"sv;
+    return mismatches == 0 && integer_mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,143 @@
+// Проверка и замер вывода CBOR на ответах синтетического города. Каждый ответ проходит PrintCbor -> LoadCbor -> json::Print,
+// результат должен совпасть байт в байт с json::Print исходного ответа. Затем сравниваются размер и время вывода обоих
+// форматов. Перед ответами так же проверяется документ с граничными числами: INT_MIN, INT_MAX, float32 и float64.
+// Сборка: g++ -std=c++17 -O2 -pthread -I.. cbor.cpp city_generator.cpp ../cbor.cpp ../json.cpp ../json_builder.cpp ../json_reader.cpp
+//         ../transport_catalogue.cpp ../transport_router.cpp ../arena.cpp ../raptor.cpp ../name_index.cpp ../domain.cpp ../geo.cpp
+//         ../map_renderer.cpp ../svg.cpp ../spatial_index.cpp ../request_handler.cpp ../thread_pool.cpp ../metrics.cpp ../histogram.cpp -o cbor
+// Запуск: ./cbor [параметры города, см. make_city] [--repeat 20]
+
+#include "cbor.h"
+#include "city_generator.h"
+#include "json_reader.h"
+#include "map_renderer.h"
+#include "request_handler.h"
+#include "transport_router.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace catalogue;
+using namespace std::literals;
+
+namespace
+{
+    std::string PrintJson(const json::Document &document)
+    {
+        std::ostringstream out;
+        json::Print(document, out);
+        return out.str();
+    }
+
+    std::string PrintCbor(const json::Document &document)
+    {
+        std::ostringstream out;
+        json::PrintCbor(document, out);
+        return out.str();
+    }
+
+    // true, если документ после записи в CBOR и чтения обратно выводится в JSON так же, как исходный
+    bool IsRoundTripExact(const json::Document &document)
+    {
+        std::istringstream input(PrintCbor(document));
+        return PrintJson(json::LoadCbor(input)) == PrintJson(document);
+    }
+
+    json::Document MakeBoundaryDocument()
+    {
+        const int int_min = std::numeric_limits<int>::min();
+        const int int_max = std::numeric_limits<int>::max();
+        json::Array numbers{0, -1, 23, 24, -24, -25, 255, 256, 65535, 65536, int_max, int_min, int_min + 1,
+                            0.5, -0.1, 1e300, static_cast<double>(int_max) + 1.0, static_cast<double>(int_min) - 1.0};
+        json::Dict root{{"numbers"s, numbers}, {"name"s, "stop"s}, {"names"s, json::Array{"stop"s, "stop"s, ""s}},
+                        {"flags"s, json::Array{true, false, nullptr}}};
+        return json::Document(root);
+    }
+
+    template <typename Function>
+    double MeasureNanoseconds(size_t repeat, Function function)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < repeat; ++i)
+        {
+            function();
+        }
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / repeat;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    bench::CityParams params;
+    size_t repeat = 20;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        const std::string_view option = argv[i];
+        if (option == "--repeat"sv)
+        {
+            repeat = std::max<size_t>(1, std::stoul(argv[i + 1]));
+        }
+        else if (!bench::ParseCityOption(option, argv[i + 1], params))
+        {
+            std::cerr << "Unknown option: "sv << option << std::endl;
+            return 1;
+        }
+    }
+
+    if (!IsRoundTripExact(MakeBoundaryDocument()))
+    {
+        std::cerr << "Boundary document differs after CBOR round trip"sv << std::endl;
+        return 1;
+    }
+
+    TransportCatalogue catalogue;
+    std::vector<json::StatRequests> stat_requests;
+    renderer::RenderSettings rend_sett;
+    router::RouterSettings rout_sett{};
+    json::ParseRequests(bench::GenerateCity(params), catalogue, stat_requests, rend_sett, rout_sett);
+    const renderer::MapRenderer map_rend(rend_sett);
+    const router::TransportRouter transport_router(rout_sett, catalogue);
+    RequestHandler request_handler(catalogue, map_rend, transport_router);
+
+    std::vector<json::Document> responses;
+    for (const auto &request : stat_requests)
+    {
+        responses.emplace_back(json::GetResponse(request_handler, request));
+    }
+
+    size_t mismatches = 0;
+    size_t json_bytes = 0;
+    size_t cbor_bytes = 0;
+    for (const auto &response : responses)
+    {
+        mismatches += !IsRoundTripExact(response);
+        json_bytes += PrintJson(response).size();
+        cbor_bytes += PrintCbor(response).size();
+    }
+
+    const double json_ns = MeasureNanoseconds(repeat, [&responses]
+                                              {
+                                                  for (const auto &response : responses)
+                                                  {
+                                                      PrintJson(response);
+                                                  } });
+    const double cbor_ns = MeasureNanoseconds(repeat, [&responses]
+                                              {
+                                                  for (const auto &response : responses)
+                                                  {
+                                                      PrintCbor(response);
+                                                  } });
+
+    const double count = static_cast<double>(responses.size());
+    std::cout << std::fixed << std::setprecision(1)
+              << "responses: "sv << responses.size() << ", round trip mismatches "sv << mismatches << '\n'
+              << "json: "sv << json_bytes << " bytes, "sv << json_ns / count << " ns/response\n"sv
+              << "cbor: "sv << cbor_bytes << " bytes, "sv << cbor_ns / count << " ns/response\n"sv
+              << "size ratio: "sv << static_cast<double>(json_bytes) / std::max<size_t>(cbor_bytes, 1)
+              << "x, speed ratio: "sv << json_ns / std::max(cbor_ns, 1.0) << "x\n"sv;
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,266 @@
+#include "city_generator.h"
+
+#include "geo.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace catalogue
+{
+    namespace bench
+    {
+        using namespace std::literals;
+
+        namespace
+        {
+            const geo::Coordinates MIN_COORDS{55.55, 37.45};
+            const double LAT_SPAN = 0.2;
+            const double LNG_SPAN = 0.3;
+
+            // Остановки, разложенные по квадратным ячейкам, чтобы быстро находить соседние
+            class StopGrid
+            {
+            public:
+                StopGrid(const std::vector<geo::Coordinates> &coords)
+                    : side_(std::max<size_t>(1, static_cast<size_t>(std::sqrt(coords.size() / 8.0)))), cells_(side_ * side_)
+                {
+                    for (size_t i = 0; i < coords.size(); ++i)
+                    {
+                        cells_[GetCell(coords[i])].push_back(i);
+                    }
+                }
+
+                // Остановки в ячейке точки и восьми соседних
+                std::vector<size_t> GetNeighbours(geo::Coordinates coords) const
+                {
+                    const size_t cell = GetCell(coords);
+                    const int row = static_cast<int>(cell / side_);
+                    const int column = static_cast<int>(cell % side_);
+                    std::vector<size_t> result;
+                    for (int r = std::max(row - 1, 0); r <= std::min<int>(row + 1, side_ - 1); ++r)
+                    {
+                        for (int c = std::max(column - 1, 0); c <= std::min<int>(column + 1, side_ - 1); ++c)
+                        {
+                            const auto &stops = cells_[r * side_ + c];
+                            result.insert(result.end(), stops.begin(), stops.end());
+                        }
+                    }
+                    return result;
+                }
+
+            private:
+                size_t GetCell(geo::Coordinates coords) const
+                {
+                    const auto to_index = [this](double offset, double span)
+                    {
+                        return std::min(static_cast<size_t>(offset / span * side_), side_ - 1);
+                    };
+                    return to_index(coords.lat - MIN_COORDS.lat, LAT_SPAN) * side_ + to_index(coords.lng - MIN_COORDS.lng, LNG_SPAN);
+                }
+
+                size_t side_;
+                std::vector<std::vector<size_t>> cells_;
+            };
+
+            std::string GetStopName(size_t index)
+            {
+                return "Stop "s + std::to_string(index);
+            }
+
+            std::string GetBusName(size_t index)
+            {
+                return std::to_string(index) + "K"s;
+            }
+
+            // Остановки одного маршрута: каждая следующая выбирается среди ближайших ещё не пройденных
+            std::vector<size_t> MakeRoute(const std::vector<geo::Coordinates> &coords, const StopGrid &grid, size_t length, std::mt19937 &random)
+            {
+                std::vector<size_t> route{random() % coords.size()};
+                std::unordered_set<size_t> visited{route.front()};
+                while (route.size() < std::min(length, coords.size()))
+                {
+                    std::vector<size_t> candidates = grid.GetNeighbours(coords[route.back()]);
+                    candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [&visited](size_t stop)
+                                                    { return visited.count(stop) > 0; }),
+                                     candidates.end());
+                    size_t next = candidates.empty() ? random() % coords.size() : candidates[random() % candidates.size()];
+                    while (visited.count(next) > 0)
+                    {
+                        next = random() % coords.size();
+                    }
+                    route.push_back(next);
+                    visited.insert(next);
+                }
+                return route;
+            }
+
+            json::Dict MakeRenderSettings()
+            {
+                return json::Dict{
+                    {"width"s, 1200.0},
+                    {"height"s, 1200.0},
+                    {"padding"s, 50.0},
+                    {"stop_radius"s, 3.0},
+                    {"line_width"s, 8.0},
+                    {"bus_label_font_size"s, 14},
+                    {"bus_label_offset"s, json::Array{7.0, 15.0}},
+                    {"stop_label_font_size"s, 12},
+                    {"stop_label_offset"s, json::Array{7.0, -3.0}},
+                    {"underlayer_color"s, json::Array{255, 255, 255, 0.85}},
+                    {"underlayer_width"s, 3.0},
+                    {"color_palette"s, json::Array{"green"s, json::Array{255, 160, 0}, "red"s, "blue"s}},
+                };
+            }
+
+            // Запросы Stop, Bus, Route, Route с alternatives, Route с departure_time и Search идут по очереди,
+            // каждый сотый запрос — Map, через раз для части карты
+            json::Array MakeStatRequests(const CityParams &params, std::mt19937 &random)
+            {
+                json::Array requests;
+                for (size_t i = 0; i < params.request_count; ++i)
+                {
+                    const int id = static_cast<int>(i + 1);
+                    const std::string stop = GetStopName(random() % params.stop_count);
+                    const std::string other_stop = GetStopName(random() % params.stop_count);
+                    if (i % 100 == 99)
+                    {
+                        json::Dict request{{"id"s, id}, {"type"s, "Map"s}};
+                        if (i % 200 == 199)
+                        {
+                            const double lat = MIN_COORDS.lat + LAT_SPAN * (random() % 1000) / 1000.0;
+                            const double lng = MIN_COORDS.lng + LNG_SPAN * (random() % 1000) / 1000.0;
+                            request.emplace("viewport"s, json::Dict{{"min_lat"s, lat}, {"min_lng"s, lng}, {"max_lat"s, lat + LAT_SPAN / 8}, {"max_lng"s, lng + LNG_SPAN / 8}});
+                        }
+                        requests.push_back(std::move(request));
+                        continue;
+                    }
+
+                    switch (i % 6)
+                    {
+                    case 0:
+                        requests.push_back(json::Dict{{"id"s, id}, {"type"s, "Stop"s}, {"name"s, stop}});
+                        break;
+                    case 1:
+                        requests.push_back(json::Dict{{"id"s, id}, {"type"s, "Bus"s}, {"name"s, GetBusName(random() % std::max<size_t>(params.bus_count, 1))}});
+                        break;
+                    case 2:
+                        requests.push_back(json::Dict{{"id"s, id}, {"type"s, "Route"s}, {"from"s, stop}, {"to"s, other_stop}});
+                        break;
+                    case 3:
+                        requests.push_back(json::Dict{{"id"s, id}, {"type"s, "Route"s}, {"from"s, stop}, {"to"s, other_stop}, {"alternatives"s, 3}});
+                        break;
+                    case 4:
+                        requests.push_back(json::Dict{{"id"s, id}, {"type"s, "Route"s}, {"from"s, stop}, {"to"s, other_stop}, {"departure_time"s, static_cast<int>(300 + random() % 1000)}});
+                        break;
+                    default:
+                        requests.push_back(json::Dict{{"id"s, id}, {"type"s, "Search"s}, {"query"s, stop.substr(0, 3 + random() % (stop.size() - 2))}, {"max_distance"s, static_cast<int>(random() % 2)}});
+                        break;
+                    }
+                }
+                return requests;
+            }
+        }
+
+        json::Document GenerateCity(const CityParams &params)
+        {
+            std::mt19937 random(params.seed);
+            std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+            std::vector<geo::Coordinates> coords;
+            for (size_t i = 0; i < params.stop_count; ++i)
+            {
+                coords.push_back({MIN_COORDS.lat + LAT_SPAN * unit(random), MIN_COORDS.lng + LNG_SPAN * unit(random)});
+            }
+            const StopGrid grid(coords);
+
+            std::vector<json::Dict> road_distances(params.stop_count);
+            json::Array buses;
+            for (size_t i = 0; i < params.bus_count && params.stop_count > 1; ++i)
+            {
+                const bool is_roundtrip = unit(random) < params.roundtrip_ratio;
+                const size_t length = std::max<size_t>(params.route_length, 2);
+                std::vector<size_t> route = MakeRoute(coords, grid, is_roundtrip ? length - 1 : length, random);
+                if (is_roundtrip)
+                {
+                    route.push_back(route.front());
+                }
+
+                json::Array stop_names;
+                for (size_t j = 0; j < route.size(); ++j)
+                {
+                    stop_names.push_back(GetStopName(route[j]));
+                    if (j > 0 && route[j - 1] != route[j])
+                    {
+                        const double distance = geo::ComputeDistance(coords[route[j - 1]], coords[route[j]]) * (1.1 + 0.4 * unit(random));
+                        road_distances[route[j - 1]].emplace(GetStopName(route[j]), std::max(1, static_cast<int>(distance)));
+                    }
+                }
+                buses.push_back(json::Dict{{"type"s, "Bus"s}, {"name"s, GetBusName(i)}, {"stops"s, std::move(stop_names)}, {"is_roundtrip"s, is_roundtrip}});
+            }
+
+            json::Array base_requests;
+            for (size_t i = 0; i < params.stop_count; ++i)
+            {
+                base_requests.push_back(json::Dict{{"type"s, "Stop"s}, {"name"s, GetStopName(i)}, {"latitude"s, coords[i].lat}, {"longitude"s, coords[i].lng}, {"road_distances"s, std::move(road_distances[i])}});
+            }
+            base_requests.insert(base_requests.end(), std::make_move_iterator(buses.begin()), std::make_move_iterator(buses.end()));
+
+            return json::Document{json::Dict{
+                {"base_requests"s, std::move(base_requests)},
+                {"render_settings"s, MakeRenderSettings()},
+                {"routing_settings"s, json::Dict{{"bus_wait_time"s, 6}, {"bus_velocity"s, 40}}},
+                {"stat_requests"s, params.stop_count > 0 ? MakeStatRequests(params, random) : json::Array{}},
+            }};
+        }
+
+        bool ParseCityOption(std::string_view option, std::string_view value, CityParams &params)
+        {
+            const std::string text(value);
+            if (option == "--stops"sv)
+            {
+                params.stop_count = std::stoul(text);
+            }
+            else if (option == "--buses"sv)
+            {
+                params.bus_count = std::stoul(text);
+            }
+            else if (option == "--route-length"sv)
+            {
+                params.route_length = std::stoul(text);
+            }
+            else if (option == "--roundtrip-ratio"sv)
+            {
+                params.roundtrip_ratio = std::stod(text);
+            }
+            else if (option == "--requests"sv)
+            {
+                params.request_count = std::stoul(text);
+            }
+            else if (option == "--seed"sv)
+            {
+                params.seed = static_cast<uint32_t>(std::stoul(text));
+            }
+            else
+            {
+                return false;
+            }
+            return true;
+        }
+
+        json::Node CityParamsToNode(const CityParams &params)
+        {
+            return json::Dict{
+                {"stops"s, static_cast<int>(params.stop_count)},
+                {"buses"s, static_cast<int>(params.bus_count)},
+                {"route_length"s, static_cast<int>(params.route_length)},
+                {"roundtrip_ratio"s, params.roundtrip_ratio},
+                {"requests"s, static_cast<int>(params.request_count)},
+                {"seed"s, static_cast<int>(params.seed)},
+            };
+        }
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "json.h"
+
+#include <cstdint>
+#include <string_view>
+
+namespace catalogue
+{
+    namespace bench
+    {
+        struct CityParams
+        {
+            size_t stop_count = 1000;
+            size_t bus_count = 100;
+            // Число остановок в описании маршрута; у кольцевого последняя совпадает с первой
+            size_t route_length = 20;
+            // Доля кольцевых маршрутов
+            double roundtrip_ratio = 0.5;
+            // Число запросов в stat_requests, поровну каждого вида
+            size_t request_count = 1000;
+            uint32_t seed = 42;
+        };
+
+        /*
+         * Входной документ справочника со случайной, но воспроизводимой при том же seed сетью:
+         * остановки разбросаны по квадрату около 20 км, маршрут идёт от остановки к одной из ближайших,
+         * дорожное расстояние между соседними остановками маршрута на 10-50% больше расстояния по прямой
+         */
+        json::Document GenerateCity(const CityParams &params);
+
+        // Разбирает параметр командной строки вида --stops 1000; возвращает false, если параметр не относится к городу
+        bool ParseCityOption(std::string_view option, std::string_view value, CityParams &params);
+
+        // Параметры города для вывода вместе с результатами
+        json::Node CityParamsToNode(const CityParams &params);
+    }
+}
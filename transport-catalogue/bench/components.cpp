@@ -0,0 +1,286 @@
+// Замеры частей справочника на синтетическом городе: разбор и вывод JSON, построение справочника, графа
+// и маршрутизаторов, ответы на запросы каждого вида. Результаты выводятся в stdout в JSON; сохранённый вывод
+// можно передать в --baseline, тогда к каждому замеру добавляется отношение к прежнему времени, а при
+// замедлении больше чем на threshold программа завершается с кодом 1.
+// Сборка: g++ -std=c++17 -O2 -pthread -I.. components.cpp city_generator.cpp ../json.cpp ../json_builder.cpp ../json_reader.cpp
+//         ../transport_catalogue.cpp ../transport_router.cpp ../arena.cpp ../raptor.cpp ../name_index.cpp ../domain.cpp ../geo.cpp
+//         ../map_renderer.cpp ../svg.cpp ../spatial_index.cpp ../request_handler.cpp ../thread_pool.cpp ../metrics.cpp ../histogram.cpp -o components
+// Запуск: ./components [параметры города, см. make_city] [--repeat N] [--filter подстрока] [--baseline base.json] [--threshold 0.1] > result.json
+
+#include "city_generator.h"
+#include "json_builder.h"
+#include "json_reader.h"
+#include "map_renderer.h"
+#include "request_handler.h"
+#include "transport_router.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace catalogue;
+using namespace std::literals;
+
+namespace
+{
+    struct Options
+    {
+        bench::CityParams city;
+        int repeat = 5;
+        std::string filter;
+        std::string baseline_path;
+        double threshold = 0.1;
+    };
+
+    struct Benchmark
+    {
+        std::string name;
+        // Сколько операций выполняет один запуск body
+        size_t operation_count;
+        std::function<void()> body;
+    };
+
+    struct Result
+    {
+        std::string name;
+        size_t operation_count;
+        double median_ns;
+        double min_ns;
+    };
+
+    std::optional<Options> ParseOptions(int argc, char *argv[])
+    {
+        Options options;
+        for (int i = 1; i + 1 < argc; i += 2)
+        {
+            const std::string_view option = argv[i];
+            const std::string value = argv[i + 1];
+            if (option == "--repeat"sv)
+            {
+                options.repeat = std::max(1, std::stoi(value));
+            }
+            else if (option == "--filter"sv)
+            {
+                options.filter = value;
+            }
+            else if (option == "--baseline"sv)
+            {
+                options.baseline_path = value;
+            }
+            else if (option == "--threshold"sv)
+            {
+                options.threshold = std::stod(value);
+            }
+            else if (!bench::ParseCityOption(option, value, options.city))
+            {
+                std::cerr << "Unknown option: "sv << option << std::endl;
+                return std::nullopt;
+            }
+        }
+        if (argc % 2 == 0)
+        {
+            std::cerr << "Missing value for option "sv << argv[argc - 1] << std::endl;
+            return std::nullopt;
+        }
+        return options;
+    }
+
+    double MeasureNanoseconds(const std::function<void()> &body, size_t iterations)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            body();
+        }
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Время одной операции: медиана и минимум по repeat замерам. Быстрые замеры повторяются,
+    // пока один замер не займёт хотя бы MIN_SAMPLE_NS, иначе результат тонет в погрешности часов
+    Result Run(const Benchmark &benchmark, int repeat)
+    {
+        const double MIN_SAMPLE_NS = 20e6;
+        const double first_time = MeasureNanoseconds(benchmark.body, 1);
+        const size_t iterations = std::max<size_t>(1, static_cast<size_t>(MIN_SAMPLE_NS / std::max(first_time, 1.0)));
+
+        std::vector<double> times;
+        for (int i = 0; i < repeat; ++i)
+        {
+            times.push_back(MeasureNanoseconds(benchmark.body, iterations) / iterations / std::max<size_t>(benchmark.operation_count, 1));
+        }
+        std::sort(times.begin(), times.end());
+        return {benchmark.name, benchmark.operation_count, times[times.size() / 2], times.front()};
+    }
+
+    // Название замера для запроса: вид запроса и его необязательные параметры
+    std::string GetRequestKind(const json::StatRequests &request)
+    {
+        std::string kind = "request_"s + request.type;
+        std::transform(kind.begin(), kind.end(), kind.begin(), [](unsigned char c)
+                       { return std::tolower(c); });
+        if (request.type == "Route"sv && request.departure_time)
+        {
+            kind += "_timetable"sv;
+        }
+        else if (request.type == "Route"sv && request.alternatives)
+        {
+            kind += "_alternatives"sv;
+        }
+        else if (request.type == "Map"sv && request.viewport)
+        {
+            kind += "_viewport"sv;
+        }
+        return kind;
+    }
+
+    std::map<std::string, double> LoadBaseline(const std::string &path)
+    {
+        std::ifstream input(path);
+        if (!input)
+        {
+            throw std::runtime_error("Can't open baseline "s + path);
+        }
+
+        const json::Document document = json::Load(input);
+        std::map<std::string, double> baseline;
+        for (const auto &result : document.GetRoot().AsMap().at("results"s).AsArray())
+        {
+            const auto &dict = result.AsMap();
+            baseline[dict.at("name"s).AsString()] = dict.at("median_ns"s).AsDouble();
+        }
+        return baseline;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const auto options = ParseOptions(argc, argv);
+    if (!options)
+    {
+        return 1;
+    }
+
+    const json::Document document = bench::GenerateCity(options->city);
+    std::string text;
+    {
+        std::ostringstream out;
+        json::Print(document, out);
+        text = out.str();
+    }
+
+    TransportCatalogue catalogue;
+    std::vector<json::StatRequests> stat_requests;
+    renderer::RenderSettings rend_sett;
+    router::RouterSettings rout_sett{};
+    json::ParseRequests(document, catalogue, stat_requests, rend_sett, rout_sett);
+    // Кэш отключён, чтобы повторные запуски замеряли поиск маршрута, а не чтение из кэша
+    rout_sett.route_cache_size = 0;
+
+    const renderer::MapRenderer map_rend(rend_sett);
+    const router::TransportRouter transport_router(rout_sett, catalogue);
+    RequestHandler request_handler(catalogue, map_rend, transport_router);
+
+    std::vector<Benchmark> benchmarks{
+        {"json_load"s, 1, [&]
+         {
+             std::istringstream input(text);
+             json::Load(input);
+         }},
+        {"json_print"s, 1, [&]
+         {
+             std::ostringstream out;
+             json::Print(document, out);
+         }},
+        {"catalogue_build"s, 1, [&]
+         {
+             TransportCatalogue built;
+             std::vector<json::StatRequests> requests;
+             renderer::RenderSettings render_settings;
+             router::RouterSettings router_settings{};
+             json::ParseRequests(document, built, requests, render_settings, router_settings);
+         }},
+        {"transport_router"s, 1, [&]
+         { router::TransportRouter built(rout_sett, catalogue); }},
+        {"graph_build"s, 1, [&]
+         {
+             graph::DirectedWeightedGraph<double> graph(transport_router.GetGraph().GetVertexCount());
+             for (const auto &bus : catalogue.GetBusList())
+             {
+                 for (const auto &edge : transport_router.MakeBusEdges(catalogue, *bus))
+                 {
+                     graph.AddEdge(edge);
+                 }
+             }
+         }},
+        {"graph_router"s, 1, [&]
+         { graph::Router<double> built(transport_router.GetGraph()); }},
+        {"alt_router"s, 1, [&]
+         { graph::AltRouter<double> built(transport_router.GetGraph(), router::RouterSettings{}.landmark_count); }},
+        {"raptor_router"s, 1, [&]
+         { router::RaptorRouter built(rout_sett, catalogue); }},
+    };
+
+    // Запросы каждого вида замеряются отдельно, время делится на число запросов
+    std::map<std::string, std::vector<const json::StatRequests *>> requests_by_kind;
+    for (const auto &request : stat_requests)
+    {
+        requests_by_kind[GetRequestKind(request)].push_back(&request);
+    }
+    for (const auto &[kind, requests] : requests_by_kind)
+    {
+        benchmarks.push_back({kind, requests.size(), [&request_handler, &requests = requests]
+                              {
+                                  for (const json::StatRequests *request : requests)
+                                  {
+                                      json::GetResponse(request_handler, *request);
+                                  }
+                              }});
+    }
+
+    const std::map<std::string, double> baseline = options->baseline_path.empty() ? std::map<std::string, double>{} : LoadBaseline(options->baseline_path);
+    bool has_regression = false;
+
+    json::Builder builder;
+    builder.StartDict().Key("city"s).Value(bench::CityParamsToNode(options->city).GetValue()).Key("results"s).StartArray();
+    for (const auto &benchmark : benchmarks)
+    {
+        if (benchmark.name.find(options->filter) == std::string::npos)
+        {
+            continue;
+        }
+
+        const Result result = Run(benchmark, options->repeat);
+        builder.StartDict()
+            .Key("name"s)
+            .Value(result.name)
+            .Key("operations"s)
+            .Value(static_cast<int>(result.operation_count))
+            .Key("median_ns"s)
+            .Value(result.median_ns)
+            .Key("min_ns"s)
+            .Value(result.min_ns);
+        std::cerr << result.name << ": "sv << result.median_ns << " ns"sv;
+
+        if (const auto it = baseline.find(result.name); it != baseline.end())
+        {
+            const double ratio = result.median_ns / it->second;
+            has_regression = has_regression || ratio > 1.0 + options->threshold;
+            builder.Key("baseline_ns"s).Value(it->second).Key("ratio"s).Value(ratio);
+            std::cerr << " ("sv << ratio << "x of baseline)"sv;
+        }
+        builder.EndDict();
+        std::cerr << std::endl;
+    }
+
+    builder.EndArray().Key("regression"s).Value(has_regression).EndDict();
+    json::Print(json::Document{builder.Build()}, std::cout);
+    std::cout << std::endl;
+    return has_regression ? 1 : 0;
+}
@@ -0,0 +1,106 @@
+// Сравнение std::unordered_map и FlatHashMap на ключах справочника: названиях и парах указателей на остановки.
+// Сборка: g++ -std=c++17 -O2 -I.. hash_map.cpp -o hash_map
+// Запуск: ./hash_map [число ключей]
+
+#include "flat_hash_map.h"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using namespace catalogue;
+
+namespace
+{
+    struct Item
+    {
+        std::string name;
+    };
+
+    using ItemPair = std::pair<const Item *, const Item *>;
+
+    // Прежний хэш пар остановок из TransportCatalogue
+    struct MultiplyPairHasher
+    {
+        size_t operator()(const ItemPair &items) const
+        {
+            return std::hash<const Item *>()(items.first) * 37 + std::hash<const Item *>()(items.second) * 37 * 37;
+        }
+    };
+
+    struct MixPairHasher
+    {
+        size_t operator()(const ItemPair &items) const
+        {
+            return MixHash(std::hash<const Item *>()(items.first)) + std::hash<const Item *>()(items.second);
+        }
+    };
+
+    template <typename Function>
+    double MeasureNanosecondsPerItem(size_t count, Function function)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        function();
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / count;
+    }
+
+    // Загрузка всех ключей и поиск каждого из них в случайном порядке
+    template <typename Map, typename Key>
+    void Measure(std::string_view title, const std::vector<Key> &keys, const std::vector<size_t> &lookups)
+    {
+        Map map;
+        const double load = MeasureNanosecondsPerItem(keys.size(), [&]
+                                                      {
+            for (size_t i = 0; i < keys.size(); ++i)
+            {
+                map.insert({keys[i], i});
+            } });
+
+        size_t checksum = 0;
+        const double lookup = MeasureNanosecondsPerItem(lookups.size(), [&]
+                                                        {
+            for (const size_t index : lookups)
+            {
+                checksum += map.find(keys[index])->second;
+            } });
+
+        std::cout << title << ": load " << load << " ns/key, lookup " << lookup << " ns/key (checksum " << checksum << ")\n";
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const size_t count = argc > 1 ? std::stoul(argv[1]) : 100000;
+
+    std::vector<std::unique_ptr<Item>> items;
+    std::vector<std::string_view> names;
+    for (size_t i = 0; i < count; ++i)
+    {
+        items.push_back(std::make_unique<Item>(Item{"Stop " + std::to_string(i)}));
+        names.push_back(items.back()->name);
+    }
+
+    // Пары соседних остановок, как в road_distances
+    std::mt19937 random(42);
+    std::vector<ItemPair> pairs;
+    for (size_t i = 0; i < count; ++i)
+    {
+        pairs.push_back({items[i].get(), items[random() % count].get()});
+    }
+
+    std::vector<size_t> lookups;
+    for (size_t i = 0; i < count * 10; ++i)
+    {
+        lookups.push_back(random() % count);
+    }
+
+    Measure<std::unordered_map<std::string_view, size_t>>("names, std::unordered_map", names, lookups);
+    Measure<FlatHashMap<std::string_view, size_t>>("names, FlatHashMap", names, lookups);
+    Measure<std::unordered_map<ItemPair, size_t, MultiplyPairHasher>>("stop pairs, std::unordered_map", pairs, lookups);
+    Measure<FlatHashMap<ItemPair, size_t, MixPairHasher>>("stop pairs, FlatHashMap", pairs, lookups);
+}
@@ -0,0 +1,204 @@
+// Влияние больших страниц на запросы Route: время ответа и промахи TLB при чтении данных, по обычным страницам и по
+// страницам 2 МиБ (RouterSettings::huge_pages). Кэш ответов выключен, чтобы каждый запрос читал таблицу маршрутов.
+// Промахи считаются через perf_event_open; если счётчик недоступен (perf_event_paranoid, контейнер), печатается n/a.
+// Сборка: g++ -std=c++17 -O2 -pthread -I.. huge_pages.cpp city_generator.cpp ../json.cpp ../json_builder.cpp ../json_reader.cpp
+//         ../transport_catalogue.cpp ../transport_router.cpp ../arena.cpp ../raptor.cpp ../name_index.cpp ../domain.cpp ../geo.cpp
+//         ../map_renderer.cpp ../svg.cpp ../spatial_index.cpp ../request_handler.cpp ../thread_pool.cpp ../metrics.cpp ../histogram.cpp -o huge_pages
+// Запуск: ./huge_pages [параметры города, см. make_city] [--engine all_pairs|alt] [--queries 1000000]
+
+#include "city_generator.h"
+#include "json_reader.h"
+#include "transport_router.h"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace catalogue;
+using namespace std::literals;
+
+namespace
+{
+    // Промахи TLB данных при чтении в пространстве пользователя для текущего потока
+    class TlbMissCounter
+    {
+    public:
+        TlbMissCounter()
+        {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+
+        ~TlbMissCounter()
+        {
+            if (fd_ >= 0)
+            {
+                close(fd_);
+            }
+        }
+
+        TlbMissCounter(const TlbMissCounter &) = delete;
+        TlbMissCounter &operator=(const TlbMissCounter &) = delete;
+
+        bool IsAvailable() const
+        {
+            return fd_ >= 0;
+        }
+
+        void Start()
+        {
+            if (fd_ >= 0)
+            {
+                ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+
+        uint64_t Stop()
+        {
+            uint64_t count = 0;
+            if (fd_ >= 0)
+            {
+                ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+                if (read(fd_, &count, sizeof(count)) != sizeof(count))
+                {
+                    count = 0;
+                }
+            }
+            return count;
+        }
+
+    private:
+        int fd_ = -1;
+    };
+
+    std::string_view GetBackingName(PageBacking backing)
+    {
+        switch (backing)
+        {
+        case PageBacking::HUGETLB:
+            return "hugetlb"sv;
+        case PageBacking::TRANSPARENT_HUGE:
+            return "transparent huge"sv;
+        default:
+            return "normal"sv;
+        }
+    }
+
+    // Объём анонимной памяти процесса на прозрачных больших страницах по /proc/self/smaps_rollup
+    std::string GetAnonHugePages()
+    {
+        std::ifstream smaps("/proc/self/smaps_rollup");
+        std::string line;
+        while (std::getline(smaps, line))
+        {
+            if (line.rfind("AnonHugePages:"sv, 0) == 0)
+            {
+                const size_t value = line.find_first_not_of(' ', line.find(':') + 1);
+                return line.substr(value);
+            }
+        }
+        return "n/a"s;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    bench::CityParams params;
+    router::RouterEngine engine = router::RouterEngine::ALL_PAIRS;
+    size_t query_count = 1000000;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        const std::string_view option = argv[i];
+        if (option == "--engine"sv)
+        {
+            engine = argv[i + 1] == "alt"sv ? router::RouterEngine::ALT : router::RouterEngine::ALL_PAIRS;
+        }
+        else if (option == "--queries"sv)
+        {
+            query_count = std::max<size_t>(1, std::stoul(argv[i + 1]));
+        }
+        else if (!bench::ParseCityOption(option, argv[i + 1], params))
+        {
+            std::cerr << "Unknown option: "sv << option << std::endl;
+            return 1;
+        }
+    }
+
+    TransportCatalogue catalogue;
+    std::vector<json::StatRequests> stat_requests;
+    renderer::RenderSettings rend_sett;
+    router::RouterSettings rout_sett{};
+    json::ParseRequests(bench::GenerateCity(params), catalogue, stat_requests, rend_sett, rout_sett);
+    rout_sett.engine = engine;
+    rout_sett.route_cache_size = 0;
+
+    std::vector<const Stop *> stops;
+    for (const auto &stop : catalogue.GetStopList())
+    {
+        stops.push_back(stop.get());
+    }
+    std::mt19937 random(params.seed);
+    std::uniform_int_distribution<size_t> stop(0, stops.size() - 1);
+    std::vector<std::pair<const Stop *, const Stop *>> queries;
+    for (size_t i = 0; i < query_count; ++i)
+    {
+        queries.push_back({stops[stop(random)], stops[stop(random)]});
+    }
+
+    TlbMissCounter tlb_misses;
+    std::cout << std::fixed << std::setprecision(1);
+    for (const bool huge_pages : {false, true})
+    {
+        rout_sett.huge_pages = huge_pages;
+        const router::TransportRouter transport_router(rout_sett, catalogue);
+
+        // Прогрев: страницы таблицы уже отображены, замер видит только промахи TLB
+        size_t found = 0;
+        for (const auto &[from, to] : queries)
+        {
+            found += transport_router.GetShortestRoute(from, to).has_value();
+        }
+
+        tlb_misses.Start();
+        const auto start = std::chrono::steady_clock::now();
+        for (const auto &[from, to] : queries)
+        {
+            found += transport_router.GetShortestRoute(from, to).has_value();
+        }
+        const double nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        const uint64_t misses = tlb_misses.Stop();
+
+        MemoryUsage usage;
+        transport_router.AddMemoryUsage(usage);
+        std::cout << (huge_pages ? "huge pages:   "sv : "normal pages: "sv) << GetBackingName(transport_router.GetPageBacking())
+                  << ", router "sv << usage.GetTotal() / 1048576.0 << " MiB, AnonHugePages "sv << GetAnonHugePages() << '\n'
+                  << "  route: "sv << nanoseconds / queries.size() << " ns/query, dTLB load misses "sv;
+        if (tlb_misses.IsAvailable())
+        {
+            std::cout << static_cast<double>(misses) / queries.size() << "/query\n"sv;
+        }
+        else
+        {
+            std::cout << "n/a\n"sv;
+        }
+        std::cout << "  found "sv << found / 2 << " of "sv << queries.size() << '\n';
+    }
+}
@@ -0,0 +1,25 @@
+// Выводит входной документ синтетического города для запуска справочника целиком.
+// Сборка: g++ -std=c++17 -O2 -I.. make_city.cpp city_generator.cpp ../json.cpp ../geo.cpp -o make_city
+// Запуск: ./make_city [--stops N] [--buses N] [--route-length N] [--roundtrip-ratio X] [--requests N] [--seed N] > city.json
+
+#include "city_generator.h"
+
+#include <iostream>
+
+using namespace catalogue;
+
+int main(int argc, char *argv[])
+{
+    bench::CityParams params;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (i + 1 >= argc || !bench::ParseCityOption(argv[i], argv[i + 1], params))
+        {
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+            return 1;
+        }
+        ++i;
+    }
+
+    json::Print(bench::GenerateCity(params), std::cout);
+}
@@ -0,0 +1,91 @@
+// Время построения NameIndex и ответа на запросы автодополнения: по началу названия и с опечатками.
+// Сборка: g++ -std=c++17 -O2 -I.. name_search.cpp ../name_index.cpp -o name_search
+// Запуск: ./name_search [число названий]
+
+#include "name_index.h"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace catalogue;
+
+namespace
+{
+    // Название из двух-четырёх слогов с номером, как "Улица Паровозная 12"
+    std::string MakeName(std::mt19937 &random)
+    {
+        static const std::vector<std::string> syllables{"ма", "ро", "ка", "ли", "на", "ва", "то", "ре", "ска", "во", "за", "ки", "ль", "ны"};
+        static const std::vector<std::string> prefixes{"Улица ", "Проспект ", "Площадь ", "Станция ", ""};
+        std::string name = prefixes[random() % prefixes.size()];
+        const int syllable_count = 2 + random() % 3;
+        for (int i = 0; i < syllable_count; ++i)
+        {
+            name += syllables[random() % syllables.size()];
+        }
+        return name + " " + std::to_string(random() % 100);
+    }
+
+    // Начало названия с одной заменённой буквой
+    std::string MakeTypo(std::string_view name, std::mt19937 &random)
+    {
+        std::string query(name.substr(0, std::min<size_t>(name.size(), 12)));
+        const size_t pos = random() % query.size();
+        if (static_cast<unsigned char>(query[pos]) < 0x80)
+        {
+            query[pos] = 'x';
+        }
+        return query;
+    }
+
+    template <typename Function>
+    double MeasureMicroseconds(Function function)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        function();
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const size_t count = argc > 1 ? std::stoul(argv[1]) : 100000;
+    std::mt19937 random(42);
+
+    std::vector<std::string> names;
+    for (size_t i = 0; i < count; ++i)
+    {
+        names.push_back(MakeName(random));
+    }
+    const std::vector<std::string_view> stop_names(names.begin(), names.end() - count / 10);
+    const std::vector<std::string_view> bus_names(names.end() - count / 10, names.end());
+
+    NameIndex index;
+    const double build_time = MeasureMicroseconds([&]
+                                                  { index = NameIndex(stop_names, bus_names); });
+    std::cout << "names: " << index.GetSize() << ", build: " << build_time / 1000 << " ms\n";
+
+    const int query_count = 1000;
+    for (const int max_distance : {0, 1, 2})
+    {
+        // Каждое название набирается по буквам, как при автодополнении
+        std::vector<std::string> queries;
+        for (int i = 0; i < query_count; ++i)
+        {
+            const std::string &name = names[random() % names.size()];
+            queries.push_back(max_distance == 0 ? name.substr(0, 1 + random() % name.size()) : MakeTypo(name, random));
+        }
+
+        size_t found = 0;
+        const double time = MeasureMicroseconds([&]
+                                                {
+            for (const auto &query : queries)
+            {
+                found += index.Find(query, max_distance, 10).size();
+            } });
+        std::cout << "max_distance " << max_distance << ": " << time / query_count << " us per query, "
+                  << double(found) / query_count << " results per query\n";
+    }
+}
@@ -0,0 +1,138 @@
+// Замер задержки обновления маршрутизатора после изменения расстояний: частичный пересчёт против полного построения.
+// Сборка: g++ -std=c++17 -O2 -pthread -I.. router_update.cpp ../transport_catalogue.cpp ../transport_router.cpp ../arena.cpp ../raptor.cpp ../name_index.cpp
+//         ../domain.cpp ../geo.cpp ../metrics.cpp ../histogram.cpp -o router_update
+// Запуск: ./router_update [размер сетки] [число изменений]
+
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace catalogue;
+
+namespace
+{
+    // Сетка size x size остановок: по каждой строке и каждому столбцу ходит некольцевой маршрут
+    TransportCatalogue MakeGridCity(int size, std::mt19937 &random)
+    {
+        TransportCatalogue catalogue;
+        const auto stop_name = [](int row, int column)
+        {
+            return "S" + std::to_string(row) + "_" + std::to_string(column);
+        };
+
+        for (int row = 0; row < size; ++row)
+        {
+            for (int column = 0; column < size; ++column)
+            {
+                catalogue.AddStop(stop_name(row, column), {55.0 + row * 0.01, 37.0 + column * 0.01});
+            }
+        }
+
+        std::uniform_int_distribution<int> distance(500, 1500);
+        for (int row = 0; row < size; ++row)
+        {
+            for (int column = 0; column + 1 < size; ++column)
+            {
+                catalogue.SetDistance(stop_name(row, column), stop_name(row, column + 1), distance(random));
+                catalogue.SetDistance(stop_name(column, row), stop_name(column + 1, row), distance(random));
+            }
+        }
+
+        for (int line = 0; line < size; ++line)
+        {
+            std::vector<std::string> row_stops, column_stops;
+            for (int i = 0; i < size; ++i)
+            {
+                row_stops.push_back(stop_name(line, i));
+                column_stops.push_back(stop_name(i, line));
+            }
+            catalogue.AddBus("R" + std::to_string(line), std::vector<std::string_view>(row_stops.begin(), row_stops.end()), false);
+            catalogue.AddBus("C" + std::to_string(line), std::vector<std::string_view>(column_stops.begin(), column_stops.end()), false);
+        }
+        catalogue.BuildStopIndex();
+        return catalogue;
+    }
+
+    double GetRouteTime(const router::TransportRouter &router, const Stop *from, const Stop *to)
+    {
+        const auto route = router.GetShortestRoute(from, to);
+        double time = 0.0;
+        if (route)
+        {
+            for (const auto &edge : *route)
+            {
+                time += edge.weight;
+            }
+        }
+        return time;
+    }
+
+    template <typename Function>
+    double MeasureMilliseconds(Function function)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        function();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const int size = argc > 1 ? std::stoi(argv[1]) : 12;
+    const int change_count = argc > 2 ? std::stoi(argv[2]) : 10;
+    const router::RouterSettings settings{6.0, 40.0};
+
+    std::mt19937 random(42);
+    TransportCatalogue catalogue = MakeGridCity(size, random);
+    const auto &stops = catalogue.GetStopList();
+    std::uniform_int_distribution<size_t> stop_index(0, stops.size() - 1);
+    std::uniform_int_distribution<int> distance(200, 3000);
+
+    std::unique_ptr<router::TransportRouter> router;
+    const double build_time = MeasureMilliseconds([&]
+                                                  { router = std::make_unique<router::TransportRouter>(settings, catalogue); });
+
+    double update_time = 0.0, rebuild_time = 0.0;
+    int mismatch_count = 0;
+    for (int change = 0; change < change_count; ++change)
+    {
+        // Меняется расстояние между соседними остановками случайной строки
+        const int row = stop_index(random) % size;
+        const int column = stop_index(random) % (size - 1);
+        const Stop *from = stops[row * size + column].get();
+        const Stop *to = stops[row * size + column + 1].get();
+        catalogue.SetDistance(from->stop_name, to->stop_name, distance(random));
+
+        update_time += MeasureMilliseconds([&]
+                                           {
+            auto updated = std::make_unique<router::TransportRouter>(*router);
+            updated->UpdateDistances(catalogue, {{from, to}});
+            router = std::move(updated); });
+
+        std::unique_ptr<router::TransportRouter> rebuilt;
+        rebuild_time += MeasureMilliseconds([&]
+                                            { rebuilt = std::make_unique<router::TransportRouter>(settings, catalogue); });
+
+        for (int sample = 0; sample < 1000; ++sample)
+        {
+            const Stop *route_from = stops[stop_index(random)].get();
+            const Stop *route_to = stops[stop_index(random)].get();
+            if (std::abs(GetRouteTime(*router, route_from, route_to) - GetRouteTime(*rebuilt, route_from, route_to)) > 1e-6)
+            {
+                ++mismatch_count;
+            }
+        }
+    }
+
+    std::cout << "stops: " << stops.size() << ", buses: " << catalogue.GetBusList().size() << '\n'
+              << "initial build: " << build_time << " ms\n"
+              << "incremental update: " << update_time / change_count << " ms per change\n"
+              << "full rebuild: " << rebuild_time / change_count << " ms per change\n"
+              << "mismatched routes: " << mismatch_count << '\n';
+    return mismatch_count == 0 ? 0 : 1;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+namespace catalogue
+{
+    /*
+     * Очередь ограниченной ёмкости для передачи данных между потоками.
+     * Push ждёт, пока в очереди освободится место, Pop — пока в ней что-нибудь появится
+     */
+    template <typename T>
+    class BoundedQueue
+    {
+    public:
+        explicit BoundedQueue(size_t capacity)
+            : capacity_(capacity > 0 ? capacity : 1) {}
+
+        void Push(T value)
+        {
+            {
+                std::unique_lock lock(mutex_);
+                has_room_.wait(lock, [this]
+                               { return items_.size() < capacity_; });
+                items_.push_back(std::move(value));
+            }
+            has_items_.notify_one();
+        }
+
+        // Возвращает nullopt, если очередь закрыта и все элементы уже забраны
+        std::optional<T> Pop()
+        {
+            std::optional<T> result;
+            {
+                std::unique_lock lock(mutex_);
+                has_items_.wait(lock, [this]
+                                { return is_closed_ || !items_.empty(); });
+                if (items_.empty())
+                {
+                    return std::nullopt;
+                }
+                result = std::move(items_.front());
+                items_.pop_front();
+            }
+            has_room_.notify_one();
+            return result;
+        }
+
+        // Сообщает получателям, что новых элементов не будет
+        void Close()
+        {
+            {
+                std::lock_guard lock(mutex_);
+                is_closed_ = true;
+            }
+            has_items_.notify_all();
+        }
+
+    private:
+        const size_t capacity_;
+        std::mutex mutex_;
+        std::condition_variable has_room_;
+        std::condition_variable has_items_;
+        std::deque<T> items_;
+        bool is_closed_ = false;
+    };
+}
@@ -0,0 +1,429 @@
+#include "cbor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+
+namespace catalogue
+{
+    namespace json
+    {
+        namespace
+        {
+            using namespace std::literals;
+
+            enum MajorType : uint8_t
+            {
+                UNSIGNED = 0,
+                NEGATIVE = 1,
+                BYTES = 2,
+                TEXT = 3,
+                ARRAY = 4,
+                MAP = 5,
+                TAG = 6,
+                SIMPLE = 7,
+            };
+
+            const uint64_t TAG_STRINGREF = 25;
+            const uint64_t TAG_STRINGREF_NAMESPACE = 256;
+
+            const uint8_t SIMPLE_FALSE = 20;
+            const uint8_t SIMPLE_TRUE = 21;
+            const uint8_t SIMPLE_NULL = 22;
+            const uint8_t FLOAT16 = 25;
+            const uint8_t FLOAT32 = 26;
+            const uint8_t FLOAT64 = 27;
+            const uint8_t INDEFINITE = 31;
+
+            // Строка попадает в таблицу, только если ссылка на неё короче самой строки
+            bool IsReferenceable(size_t length, size_t next_index)
+            {
+                if (next_index < 24)
+                {
+                    return length >= 3;
+                }
+                if (next_index < 0x100)
+                {
+                    return length >= 4;
+                }
+                if (next_index < 0x10000)
+                {
+                    return length >= 5;
+                }
+                if (next_index < 0x100000000)
+                {
+                    return length >= 7;
+                }
+                return length >= 11;
+            }
+
+            //------------Print------------
+
+            void WriteBigEndian(std::ostream &out, uint64_t value, int size)
+            {
+                char bytes[8];
+                for (int i = size - 1; i >= 0; --i)
+                {
+                    bytes[i] = static_cast<char>(value & 0xff);
+                    value >>= 8;
+                }
+                out.write(bytes, size);
+            }
+
+            // Выводит начальный байт элемента и его аргумент в самой короткой форме
+            void WriteHead(std::ostream &out, uint8_t major_type, uint64_t argument)
+            {
+                const uint8_t major = static_cast<uint8_t>(major_type << 5);
+                if (argument < 24)
+                {
+                    out.put(static_cast<char>(major | argument));
+                }
+                else if (argument <= 0xff)
+                {
+                    out.put(static_cast<char>(major | 24));
+                    WriteBigEndian(out, argument, 1);
+                }
+                else if (argument <= 0xffff)
+                {
+                    out.put(static_cast<char>(major | 25));
+                    WriteBigEndian(out, argument, 2);
+                }
+                else if (argument <= 0xffffffff)
+                {
+                    out.put(static_cast<char>(major | 26));
+                    WriteBigEndian(out, argument, 4);
+                }
+                else
+                {
+                    out.put(static_cast<char>(major | 27));
+                    WriteBigEndian(out, argument, 8);
+                }
+            }
+
+            class Encoder
+            {
+            public:
+                explicit Encoder(std::ostream &out)
+                    : out_(out) {}
+
+                void Encode(const Node &node)
+                {
+                    std::visit([this](const auto &value)
+                               { EncodeValue(value); }, node.GetValue());
+                }
+
+            private:
+                void EncodeValue(std::nullptr_t)
+                {
+                    out_.put(static_cast<char>(SIMPLE << 5 | SIMPLE_NULL));
+                }
+
+                void EncodeValue(bool value)
+                {
+                    out_.put(static_cast<char>(SIMPLE << 5 | (value ? SIMPLE_TRUE : SIMPLE_FALSE)));
+                }
+
+                void EncodeValue(int value)
+                {
+                    if (value >= 0)
+                    {
+                        WriteHead(out_, UNSIGNED, static_cast<uint64_t>(value));
+                    }
+                    else
+                    {
+                        WriteHead(out_, NEGATIVE, static_cast<uint64_t>(-(static_cast<int64_t>(value) + 1)));
+                    }
+                }
+
+                void EncodeValue(double value)
+                {
+                    const float narrow = static_cast<float>(value);
+                    if (static_cast<double>(narrow) == value)
+                    {
+                        uint32_t bits;
+                        std::memcpy(&bits, &narrow, sizeof(bits));
+                        out_.put(static_cast<char>(SIMPLE << 5 | FLOAT32));
+                        WriteBigEndian(out_, bits, 4);
+                    }
+                    else
+                    {
+                        uint64_t bits;
+                        std::memcpy(&bits, &value, sizeof(bits));
+                        out_.put(static_cast<char>(SIMPLE << 5 | FLOAT64));
+                        WriteBigEndian(out_, bits, 8);
+                    }
+                }
+
+                void EncodeValue(const std::string &value)
+                {
+                    EncodeString(value);
+                }
+
+                void EncodeValue(const Array &array)
+                {
+                    WriteHead(out_, ARRAY, array.size());
+                    for (const auto &elem : array)
+                    {
+                        Encode(elem);
+                    }
+                }
+
+                void EncodeValue(const Dict &dict)
+                {
+                    WriteHead(out_, MAP, dict.size());
+                    for (const auto &[key, value] : dict)
+                    {
+                        EncodeString(key);
+                        Encode(value);
+                    }
+                }
+
+                void EncodeString(std::string_view value)
+                {
+                    if (const auto it = string_refs_.find(value); it != string_refs_.end())
+                    {
+                        WriteHead(out_, TAG, TAG_STRINGREF);
+                        WriteHead(out_, UNSIGNED, it->second);
+                        return;
+                    }
+
+                    if (IsReferenceable(value.size(), string_refs_.size()))
+                    {
+                        string_refs_.emplace(value, string_refs_.size());
+                    }
+                    WriteHead(out_, TEXT, value.size());
+                    out_.write(value.data(), static_cast<std::streamsize>(value.size()));
+                }
+
+                std::ostream &out_;
+                // Строки указывают на содержимое выводимого документа
+                std::unordered_map<std::string_view, uint64_t> string_refs_;
+            };
+
+            //------------Load------------
+
+            class Decoder
+            {
+            public:
+                explicit Decoder(std::istream &input)
+                    : input_(input) {}
+
+                Node Decode()
+                {
+                    const uint8_t initial = ReadByte();
+                    const uint8_t major_type = initial >> 5;
+                    const uint8_t info = initial & 0x1f;
+
+                    if (major_type == SIMPLE)
+                    {
+                        return DecodeSimple(info);
+                    }
+
+                    const uint64_t argument = ReadArgument(info);
+                    switch (major_type)
+                    {
+                    case UNSIGNED:
+                        return MakeInteger(static_cast<double>(argument), argument <= static_cast<uint64_t>(std::numeric_limits<int>::max()));
+                    case NEGATIVE:
+                        // -1 - argument не меньше INT_MIN
+                        return MakeInteger(-1.0 - static_cast<double>(argument), argument <= static_cast<uint64_t>(std::numeric_limits<int>::max()));
+                    case BYTES:
+                        throw ParsingError("Byte strings are not supported"s);
+                    case TEXT:
+                        return ReadText(argument);
+                    // Число элементов из входа не проверено, поэтому место под них заранее не резервируется:
+                    // каждый элемент занимает хотя бы байт, и при ложном числе чтение упрётся в конец входа
+                    case ARRAY:
+                    {
+                        Array result;
+                        for (uint64_t i = 0; i < argument; ++i)
+                        {
+                            result.push_back(Decode());
+                        }
+                        return Node(std::move(result));
+                    }
+                    case MAP:
+                    {
+                        Dict result;
+                        for (uint64_t i = 0; i < argument; ++i)
+                        {
+                            Node key = Decode();
+                            if (!key.IsString())
+                            {
+                                throw ParsingError("Map key is not a string"s);
+                            }
+                            result.emplace(key.AsString(), Decode());
+                        }
+                        return Node(std::move(result));
+                    }
+                    default:
+                        return DecodeTag(argument);
+                    }
+                }
+
+            private:
+                uint8_t ReadByte()
+                {
+                    const auto c = input_.get();
+                    if (c == std::char_traits<char>::eof())
+                    {
+                        throw ParsingError("Unexpected end of CBOR input"s);
+                    }
+                    return static_cast<uint8_t>(c);
+                }
+
+                uint64_t ReadBigEndian(int size)
+                {
+                    uint64_t value = 0;
+                    for (int i = 0; i < size; ++i)
+                    {
+                        value = value << 8 | ReadByte();
+                    }
+                    return value;
+                }
+
+                uint64_t ReadArgument(uint8_t info)
+                {
+                    if (info < 24)
+                    {
+                        return info;
+                    }
+                    if (info <= 27)
+                    {
+                        return ReadBigEndian(1 << (info - 24));
+                    }
+                    if (info == INDEFINITE)
+                    {
+                        throw ParsingError("Indefinite-length items are not supported"s);
+                    }
+                    throw ParsingError("Invalid CBOR additional info"s);
+                }
+
+                static Node MakeInteger(double value, bool fits_int)
+                {
+                    if (fits_int)
+                    {
+                        return Node(static_cast<int>(value));
+                    }
+                    return Node(value);
+                }
+
+                Node DecodeSimple(uint8_t info)
+                {
+                    switch (info)
+                    {
+                    case SIMPLE_FALSE:
+                        return Node(false);
+                    case SIMPLE_TRUE:
+                        return Node(true);
+                    case SIMPLE_NULL:
+                        return Node(nullptr);
+                    case FLOAT16:
+                    {
+                        const auto bits = static_cast<uint32_t>(ReadBigEndian(2));
+                        const int exponent = (bits >> 10) & 0x1f;
+                        const double mantissa = bits & 0x3ff;
+                        double value;
+                        if (exponent == 0)
+                        {
+                            value = std::ldexp(mantissa, -24);
+                        }
+                        else if (exponent == 0x1f)
+                        {
+                            value = mantissa == 0 ? std::numeric_limits<double>::infinity() : std::numeric_limits<double>::quiet_NaN();
+                        }
+                        else
+                        {
+                            value = std::ldexp(mantissa + 1024, exponent - 25);
+                        }
+                        return Node((bits & 0x8000) ? -value : value);
+                    }
+                    case FLOAT32:
+                    {
+                        const auto bits = static_cast<uint32_t>(ReadBigEndian(4));
+                        float value;
+                        std::memcpy(&value, &bits, sizeof(value));
+                        return Node(static_cast<double>(value));
+                    }
+                    case FLOAT64:
+                    {
+                        const uint64_t bits = ReadBigEndian(8);
+                        double value;
+                        std::memcpy(&value, &bits, sizeof(value));
+                        return Node(value);
+                    }
+                    default:
+                        throw ParsingError("Unsupported CBOR simple value"s);
+                    }
+                }
+
+                // Длина из входа не проверена: строка читается частями, и память растёт только вместе с прочитанными данными
+                Node ReadText(uint64_t length)
+                {
+                    constexpr uint64_t CHUNK_SIZE = 64 * 1024;
+                    std::string value;
+                    while (value.size() < length)
+                    {
+                        const size_t offset = value.size();
+                        const auto chunk = static_cast<size_t>(std::min(CHUNK_SIZE, length - offset));
+                        value.resize(offset + chunk);
+                        if (!input_.read(value.data() + offset, static_cast<std::streamsize>(chunk)))
+                        {
+                            throw ParsingError("Unexpected end of CBOR input"s);
+                        }
+                    }
+                    if (namespace_depth_ > 0 && IsReferenceable(value.size(), strings_.size()))
+                    {
+                        strings_.push_back(value);
+                    }
+                    return Node(std::move(value));
+                }
+
+                Node DecodeTag(uint64_t tag)
+                {
+                    if (tag == TAG_STRINGREF_NAMESPACE)
+                    {
+                        // Вложенное пространство строк начинает таблицу заново
+                        std::vector<std::string> outer_strings = std::move(strings_);
+                        strings_.clear();
+                        ++namespace_depth_;
+                        Node result = Decode();
+                        --namespace_depth_;
+                        strings_ = std::move(outer_strings);
+                        return result;
+                    }
+                    if (tag == TAG_STRINGREF)
+                    {
+                        const Node index = Decode();
+                        if (namespace_depth_ == 0 || !index.IsInt() || index.AsInt() < 0 || static_cast<size_t>(index.AsInt()) >= strings_.size())
+                        {
+                            throw ParsingError("Invalid string reference"s);
+                        }
+                        return Node(strings_[index.AsInt()]);
+                    }
+                    // Значения с прочими тегами читаются без учёта тега
+                    return Decode();
+                }
+
+                std::istream &input_;
+                std::vector<std::string> strings_;
+                int namespace_depth_ = 0;
+            };
+        } // namespace
+
+        void PrintCbor(const Document &doc, std::ostream &output)
+        {
+            WriteHead(output, TAG, TAG_STRINGREF_NAMESPACE);
+            Encoder(output).Encode(doc.GetRoot());
+        }
+
+        Document LoadCbor(std::istream &input)
+        {
+            return Document{Decoder(input).Decode()};
+        }
+
+    } // namespace json
+} // namespace catalogue
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "json.h"
+
+#include <iostream>
+
+namespace catalogue
+{
+    namespace json
+    {
+        /*
+         * Двоичное представление документа в формате CBOR (RFC 8949) с той же структурой, что и JSON.
+         * Документ оборачивается в пространство строк stringref (тег 256): повторная строка
+         * заменяется тегом 25 с номером её первого появления. Вещественные числа выводятся как
+         * IEEE 754 float64 или float32, если значение представимо без потерь
+         */
+        void PrintCbor(const Document &doc, std::ostream &output);
+
+        // Читает документ, записанный PrintCbor. Строки неопределённой длины не поддерживаются
+        Document LoadCbor(std::istream &input);
+
+    } // namespace json
+} // namespace catalogue
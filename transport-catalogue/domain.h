@@ -1,8 +1,10 @@
 #pragma once
 
+#include "flat_hash_map.h"
 #include "geo.h"
 #include <vector>
 #include <string>
+#include <string_view>
 /*
  * В этом файле вы можете разместить классы/структуры, которые являются частью предметной области (domain)
  * вашего приложения и не зависят от транспортного справочника. Например Автобусные маршруты и Остановки.
@@ -26,8 +28,13 @@ struct Bus
     std::string bus_name;
     std::vector<const Stop *> bus_stops;
     bool is_roundtrip;
+    // Времена отправления с первой остановки в минутах от начала суток, по возрастанию. Пусто, если расписание не задано
+    std::vector<double> departures;
 };
 
+// Маршруты по названиям
+using BusNameIndex = catalogue::FlatHashMap<std::string_view, const Bus *>;
+
 struct BusInfo
 {
     int stops_count = 0;
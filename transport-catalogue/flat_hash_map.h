@@ -0,0 +1,500 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace catalogue
+{
+    // Перемешивает биты хэша: std::hash для указателей и целых чисел возвращает само значение
+    inline uint64_t MixHash(uint64_t hash)
+    {
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        hash *= 0xc4ceb9fe1a85ec53ULL;
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+    /*
+     * Хэш-таблица с открытой адресацией в духе Swiss table.
+     * Элементы лежат в одном массиве, рядом — массив управляющих байтов: для занятой ячейки
+     * в нём хранятся 7 младших битов хэша, иначе отметка пустой или удалённой ячейки.
+     * Поиск сравнивает сразу группу из 16 управляющих байтов (SSE2, если доступно) и обращается
+     * к элементам только при совпадении этих битов. Вставка может перемещать элементы,
+     * поэтому указатели и итераторы на них после вставки недействительны
+     */
+    template <typename Key, typename Value, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+    class FlatHashMap
+    {
+    public:
+        using value_type = std::pair<const Key, Value>;
+
+        template <bool IsConst>
+        class Iterator
+        {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = FlatHashMap::value_type;
+            using difference_type = std::ptrdiff_t;
+            using reference = std::conditional_t<IsConst, const value_type &, value_type &>;
+            using pointer = std::conditional_t<IsConst, const value_type *, value_type *>;
+
+            Iterator() = default;
+
+            // Итератор на изменяемый элемент приводится к итератору на константный
+            template <bool IsSourceConst = IsConst, typename = std::enable_if_t<!IsSourceConst>>
+            operator Iterator<true>() const
+            {
+                return Iterator<true>(control_, slots_, index_, capacity_);
+            }
+
+            reference operator*() const
+            {
+                return slots_[index_];
+            }
+
+            pointer operator->() const
+            {
+                return slots_ + index_;
+            }
+
+            Iterator &operator++()
+            {
+                ++index_;
+                SkipFree();
+                return *this;
+            }
+
+            Iterator operator++(int)
+            {
+                Iterator result = *this;
+                ++*this;
+                return result;
+            }
+
+            bool operator==(const Iterator &other) const
+            {
+                return index_ == other.index_;
+            }
+
+            bool operator!=(const Iterator &other) const
+            {
+                return index_ != other.index_;
+            }
+
+        private:
+            friend class FlatHashMap;
+            template <bool>
+            friend class Iterator;
+
+            Iterator(const int8_t *control, value_type *slots, size_t index, size_t capacity)
+                : control_(control), slots_(slots), index_(index), capacity_(capacity) {}
+
+            void SkipFree()
+            {
+                while (index_ < capacity_ && control_[index_] < 0)
+                {
+                    ++index_;
+                }
+            }
+
+            const int8_t *control_ = nullptr;
+            value_type *slots_ = nullptr;
+            size_t index_ = 0;
+            size_t capacity_ = 0;
+        };
+
+        using iterator = Iterator<false>;
+        using const_iterator = Iterator<true>;
+
+        FlatHashMap() = default;
+
+        FlatHashMap(const FlatHashMap &other)
+        {
+            if (other.capacity_ == 0)
+            {
+                return;
+            }
+            Allocate(other.capacity_);
+            std::copy(other.control_.get(), other.control_.get() + capacity_, control_.get());
+            for (size_t i = 0; i < capacity_; ++i)
+            {
+                if (IsFull(control_[i]))
+                {
+                    new (slots_ + i) value_type(other.slots_[i]);
+                }
+            }
+            size_ = other.size_;
+            deleted_count_ = other.deleted_count_;
+        }
+
+        FlatHashMap(FlatHashMap &&other) noexcept
+        {
+            Swap(other);
+        }
+
+        FlatHashMap &operator=(FlatHashMap other) noexcept
+        {
+            Swap(other);
+            return *this;
+        }
+
+        ~FlatHashMap()
+        {
+            Destroy();
+        }
+
+        iterator begin()
+        {
+            iterator it(control_.get(), slots_, 0, capacity_);
+            it.SkipFree();
+            return it;
+        }
+
+        iterator end()
+        {
+            return iterator(control_.get(), slots_, capacity_, capacity_);
+        }
+
+        const_iterator begin() const
+        {
+            return const_cast<FlatHashMap *>(this)->begin();
+        }
+
+        const_iterator end() const
+        {
+            return const_cast<FlatHashMap *>(this)->end();
+        }
+
+        size_t size() const
+        {
+            return size_;
+        }
+
+        bool empty() const
+        {
+            return size_ == 0;
+        }
+
+        // Память ячеек и байтов состояния; память, на которую ссылаются ключи и значения, не учитывается
+        size_t GetMemoryUsage() const
+        {
+            return capacity_ * (sizeof(value_type) + sizeof(int8_t));
+        }
+
+        void clear()
+        {
+            Destroy();
+        }
+
+        void reserve(size_t count)
+        {
+            const size_t capacity = GetCapacityFor(count);
+            if (capacity > capacity_)
+            {
+                Rehash(capacity);
+            }
+        }
+
+        iterator find(const Key &key)
+        {
+            return MakeIterator(Find(key, GetHash(key)));
+        }
+
+        const_iterator find(const Key &key) const
+        {
+            return const_cast<FlatHashMap *>(this)->find(key);
+        }
+
+        size_t count(const Key &key) const
+        {
+            return Find(key, GetHash(key)) != capacity_ ? 1 : 0;
+        }
+
+        Value &at(const Key &key)
+        {
+            const size_t index = Find(key, GetHash(key));
+            if (index == capacity_)
+            {
+                throw std::out_of_range("FlatHashMap::at: key not found");
+            }
+            return slots_[index].second;
+        }
+
+        const Value &at(const Key &key) const
+        {
+            return const_cast<FlatHashMap *>(this)->at(key);
+        }
+
+        Value &operator[](const Key &key)
+        {
+            return try_emplace(key).first->second;
+        }
+
+        template <typename... Args>
+        std::pair<iterator, bool> try_emplace(const Key &key, Args &&...args)
+        {
+            const size_t hash = GetHash(key);
+            if (const size_t index = Find(key, hash); index != capacity_)
+            {
+                return {MakeIterator(index), false};
+            }
+
+            const size_t index = PrepareInsert(hash);
+            new (slots_ + index) value_type(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+            return {MakeIterator(index), true};
+        }
+
+        template <typename... Args>
+        std::pair<iterator, bool> emplace(const Key &key, Args &&...args)
+        {
+            return try_emplace(key, std::forward<Args>(args)...);
+        }
+
+        std::pair<iterator, bool> insert(value_type value)
+        {
+            return try_emplace(value.first, std::move(value.second));
+        }
+
+        template <typename It>
+        void insert(It first, It last)
+        {
+            for (; first != last; ++first)
+            {
+                try_emplace(first->first, first->second);
+            }
+        }
+
+        size_t erase(const Key &key)
+        {
+            const size_t index = Find(key, GetHash(key));
+            if (index == capacity_)
+            {
+                return 0;
+            }
+            EraseAt(index);
+            return 1;
+        }
+
+        iterator erase(const_iterator position)
+        {
+            EraseAt(position.index_);
+            iterator next(control_.get(), slots_, position.index_ + 1, capacity_);
+            next.SkipFree();
+            return next;
+        }
+
+    private:
+        static constexpr size_t GROUP_SIZE = 16;
+        static constexpr int8_t EMPTY = -128;
+        static constexpr int8_t DELETED = -2;
+
+        static bool IsFull(int8_t control)
+        {
+            return control >= 0;
+        }
+
+        // Биты маски отмечают байты группы, равные value
+        static uint32_t Match(const int8_t *group, int8_t value)
+        {
+#if defined(__SSE2__)
+            const __m128i control = _mm_loadu_si128(reinterpret_cast<const __m128i *>(group));
+            return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(value), control));
+#else
+            uint32_t mask = 0;
+            for (size_t i = 0; i < GROUP_SIZE; ++i)
+            {
+                mask |= uint32_t(group[i] == value) << i;
+            }
+            return mask;
+#endif
+        }
+
+        static uint32_t MatchFree(const int8_t *group)
+        {
+#if defined(__SSE2__)
+            const __m128i control = _mm_loadu_si128(reinterpret_cast<const __m128i *>(group));
+            return _mm_movemask_epi8(_mm_cmplt_epi8(control, _mm_set1_epi8(-1)));
+#else
+            uint32_t mask = 0;
+            for (size_t i = 0; i < GROUP_SIZE; ++i)
+            {
+                mask |= uint32_t(group[i] < -1) << i;
+            }
+            return mask;
+#endif
+        }
+
+        static int CountTrailingZeros(uint32_t mask)
+        {
+            return __builtin_ctz(mask);
+        }
+
+        // Заполненность таблицы вместе с удалёнными ячейками не превышает 7/8
+        static size_t GetCapacityFor(size_t count)
+        {
+            size_t capacity = GROUP_SIZE;
+            while (capacity * 7 / 8 < count)
+            {
+                capacity *= 2;
+            }
+            return capacity;
+        }
+
+        static size_t GetHash(const Key &key)
+        {
+            return MixHash(Hash{}(key));
+        }
+
+        // Группы перебираются с растущим шагом; при числе групп, равном степени двойки, обходятся все
+        size_t Find(const Key &key, size_t hash) const
+        {
+            if (capacity_ == 0)
+            {
+                return capacity_;
+            }
+
+            const int8_t fingerprint = hash & 0x7F;
+            const size_t group_mask = capacity_ / GROUP_SIZE - 1;
+            size_t group = (hash >> 7) & group_mask;
+            for (size_t step = 1;; ++step)
+            {
+                const int8_t *group_control = control_.get() + group * GROUP_SIZE;
+                for (uint32_t mask = Match(group_control, fingerprint); mask != 0; mask &= mask - 1)
+                {
+                    const size_t index = group * GROUP_SIZE + CountTrailingZeros(mask);
+                    if (KeyEqual{}(slots_[index].first, key))
+                    {
+                        return index;
+                    }
+                }
+                if (Match(group_control, EMPTY) != 0 || step > group_mask)
+                {
+                    return capacity_;
+                }
+                group = (group + step) & group_mask;
+            }
+        }
+
+        // Находит ячейку для нового ключа и отмечает её занятой
+        size_t PrepareInsert(size_t hash)
+        {
+            if (capacity_ == 0 || (size_ + deleted_count_ + 1) > capacity_ * 7 / 8)
+            {
+                // Если место заняли удалённые ячейки, достаточно перестроить таблицу того же размера
+                Rehash(GetCapacityFor(size_ + 1) > capacity_ ? GetCapacityFor(size_ + 1) : capacity_);
+            }
+
+            const size_t group_mask = capacity_ / GROUP_SIZE - 1;
+            size_t group = (hash >> 7) & group_mask;
+            for (size_t step = 1;; ++step)
+            {
+                if (const uint32_t mask = MatchFree(control_.get() + group * GROUP_SIZE); mask != 0)
+                {
+                    const size_t index = group * GROUP_SIZE + CountTrailingZeros(mask);
+                    if (control_[index] == DELETED)
+                    {
+                        --deleted_count_;
+                    }
+                    control_[index] = hash & 0x7F;
+                    ++size_;
+                    return index;
+                }
+                group = (group + step) & group_mask;
+            }
+        }
+
+        void EraseAt(size_t index)
+        {
+            slots_[index].~value_type();
+            --size_;
+            // Поиск останавливается на группе с пустой ячейкой, поэтому в такой группе отметка удаления не нужна
+            const int8_t *group_control = control_.get() + index / GROUP_SIZE * GROUP_SIZE;
+            if (Match(group_control, EMPTY) != 0)
+            {
+                control_[index] = EMPTY;
+            }
+            else
+            {
+                control_[index] = DELETED;
+                ++deleted_count_;
+            }
+        }
+
+        void Rehash(size_t capacity)
+        {
+            FlatHashMap rehashed;
+            rehashed.Allocate(capacity);
+            for (size_t i = 0; i < capacity_; ++i)
+            {
+                if (IsFull(control_[i]))
+                {
+                    const size_t index = rehashed.PrepareInsert(GetHash(slots_[i].first));
+                    new (rehashed.slots_ + index) value_type(std::move(const_cast<Key &>(slots_[i].first)), std::move(slots_[i].second));
+                }
+            }
+            Swap(rehashed);
+        }
+
+        void Allocate(size_t capacity)
+        {
+            capacity_ = capacity;
+            control_ = std::make_unique<int8_t[]>(capacity);
+            std::fill(control_.get(), control_.get() + capacity, EMPTY);
+            slots_ = std::allocator<value_type>{}.allocate(capacity);
+        }
+
+        void Destroy()
+        {
+            for (size_t i = 0; i < capacity_; ++i)
+            {
+                if (IsFull(control_[i]))
+                {
+                    slots_[i].~value_type();
+                }
+            }
+            if (slots_ != nullptr)
+            {
+                std::allocator<value_type>{}.deallocate(slots_, capacity_);
+            }
+            control_.reset();
+            slots_ = nullptr;
+            capacity_ = 0;
+            size_ = 0;
+            deleted_count_ = 0;
+        }
+
+        void Swap(FlatHashMap &other) noexcept
+        {
+            std::swap(control_, other.control_);
+            std::swap(slots_, other.slots_);
+            std::swap(capacity_, other.capacity_);
+            std::swap(size_, other.size_);
+            std::swap(deleted_count_, other.deleted_count_);
+        }
+
+        iterator MakeIterator(size_t index)
+        {
+            return iterator(control_.get(), slots_, index, capacity_);
+        }
+
+        std::unique_ptr<int8_t[]> control_;
+        value_type *slots_ = nullptr;
+        size_t capacity_ = 0;
+        size_t size_ = 0;
+        size_t deleted_count_ = 0;
+    };
+}
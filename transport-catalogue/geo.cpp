@@ -1,6 +1,7 @@
 #define _USE_MATH_DEFINES
 #include "geo.h"
 
+#include <algorithm>
 #include <cmath>
 
 namespace geo
@@ -27,4 +28,65 @@ namespace geo
         const double dr = M_PI / 180.0;
         return acos(sin(from.lat * dr) * sin(to.lat * dr) + cos(from.lat * dr) * cos(to.lat * dr) * cos(abs(from.lng - to.lng) * dr)) * 6371000;
     }
+
+    bool BoundingBox::Contains(Coordinates point) const
+    {
+        return min.lat <= point.lat && point.lat <= max.lat && min.lng <= point.lng && point.lng <= max.lng;
+    }
+
+    bool BoundingBox::Intersects(Coordinates from, Coordinates to) const
+    {
+        // Отсечение отрезка по Лиангу-Барски: сужаем параметр t в [t_min, t_max] по каждой границе
+        const double d_lat = to.lat - from.lat;
+        const double d_lng = to.lng - from.lng;
+        const double p[] = {-d_lng, d_lng, -d_lat, d_lat};
+        const double q[] = {from.lng - min.lng, max.lng - from.lng, from.lat - min.lat, max.lat - from.lat};
+
+        double t_min = 0.0;
+        double t_max = 1.0;
+        for (int i = 0; i < 4; ++i)
+        {
+            if (p[i] == 0.0)
+            {
+                if (q[i] < 0.0)
+                {
+                    return false;
+                }
+                continue;
+            }
+
+            const double t = q[i] / p[i];
+            if (p[i] < 0.0)
+            {
+                t_min = std::max(t_min, t);
+            }
+            else
+            {
+                t_max = std::min(t_max, t);
+            }
+
+            if (t_min > t_max)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    BoundingBox TileToBoundingBox(int zoom, int x, int y)
+    {
+        const double tiles = std::ldexp(1.0, zoom);
+        // Номера тайлов переводятся в double до сложения, чтобы x + 1 не переполнял int
+        const auto tile_lng = [tiles](double tile_x)
+        {
+            return tile_x / tiles * 360.0 - 180.0;
+        };
+        const auto tile_lat = [tiles](double tile_y)
+        {
+            return std::atan(std::sinh(M_PI * (1.0 - 2.0 * tile_y / tiles))) * 180.0 / M_PI;
+        };
+
+        // Номер тайла по y растёт к югу, поэтому верхняя граница тайла y — это его максимальная широта
+        return {{tile_lat(y + 1.0), tile_lng(x)}, {tile_lat(y), tile_lng(x + 1.0)}};
+    }
 } // namespace geo
\ No newline at end of file
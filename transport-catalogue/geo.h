@@ -12,4 +12,19 @@ namespace geo
     };
 
     double ComputeDistance(Coordinates from, Coordinates to);
+
+    // Прямоугольная область в координатах широты и долготы
+    struct BoundingBox
+    {
+        Coordinates min;
+        Coordinates max;
+
+        bool Contains(Coordinates point) const;
+
+        // Проверяет, пересекает ли отрезок from-to область (отрезок считается прямым в координатах lat/lng)
+        bool Intersects(Coordinates from, Coordinates to) const;
+    };
+
+    // Возвращает область тайла z/x/y в проекции Web Mercator
+    BoundingBox TileToBoundingBox(int zoom, int x, int y);
 }
@@ -3,6 +3,7 @@
 #include "ranges.h"
 
 #include <cstdlib>
+#include <memory_resource>
 #include <vector>
 
 namespace graph {
@@ -22,27 +23,45 @@ struct Edge {
 template <typename Weight>
 class DirectedWeightedGraph {
 private:
-    using IncidenceList = std::vector<EdgeId>;
+    using IncidenceList = std::pmr::vector<EdgeId>;
     using IncidentEdgesRange = ranges::Range<typename IncidenceList::const_iterator>;
 
 public:
     DirectedWeightedGraph() = default;
-    explicit DirectedWeightedGraph(size_t vertex_count);
+    // Рёбра и списки смежности размещаются в resource, например в ArenaResource
+    explicit DirectedWeightedGraph(size_t vertex_count,
+                                   std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+    // Копия other, размещённая в resource
+    DirectedWeightedGraph(const DirectedWeightedGraph& other, std::pmr::memory_resource* resource);
     EdgeId AddEdge(const Edge<Weight>& edge);
+    // Добавляет рёбра по порядку, заранее выделив память точно под них: в монотонной арене ничего не пропадает
+    void AddEdges(const std::vector<Edge<Weight>>& edges);
+    void SetEdgeWeight(EdgeId edge_id, Weight weight);
 
     size_t GetVertexCount() const;
     size_t GetEdgeCount() const;
     const Edge<Weight>& GetEdge(EdgeId edge_id) const;
     IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
 
+    // Байты, занятые рёбрами и списками смежности
+    size_t GetMemoryUsage() const;
+
 private:
-    std::vector<Edge<Weight>> edges_;
-    std::vector<IncidenceList> incidence_lists_;
+    std::pmr::vector<Edge<Weight>> edges_;
+    std::pmr::vector<IncidenceList> incidence_lists_;
 };
 
 template <typename Weight>
-DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
-    : incidence_lists_(vertex_count) {
+DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count, std::pmr::memory_resource* resource)
+    : edges_(resource)
+    , incidence_lists_(vertex_count, resource) {
+}
+
+template <typename Weight>
+DirectedWeightedGraph<Weight>::DirectedWeightedGraph(const DirectedWeightedGraph& other,
+                                                     std::pmr::memory_resource* resource)
+    : edges_(other.edges_, resource)
+    , incidence_lists_(other.incidence_lists_, resource) {
 }
 
 template <typename Weight>
@@ -53,6 +72,26 @@ EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
     return id;
 }
 
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::AddEdges(const std::vector<Edge<Weight>>& edges) {
+    std::vector<size_t> added_counts(incidence_lists_.size(), 0);
+    for (const auto& edge : edges) {
+        ++added_counts.at(edge.from);
+    }
+    edges_.reserve(edges_.size() + edges.size());
+    for (VertexId vertex = 0; vertex < incidence_lists_.size(); ++vertex) {
+        incidence_lists_[vertex].reserve(incidence_lists_[vertex].size() + added_counts[vertex]);
+    }
+    for (const auto& edge : edges) {
+        AddEdge(edge);
+    }
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::SetEdgeWeight(EdgeId edge_id, Weight weight) {
+    edges_.at(edge_id).weight = weight;
+}
+
 template <typename Weight>
 size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
     return incidence_lists_.size();
@@ -73,4 +112,13 @@ typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
 DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
     return ranges::AsRange(incidence_lists_.at(vertex));
 }
+
+template <typename Weight>
+size_t DirectedWeightedGraph<Weight>::GetMemoryUsage() const {
+    size_t bytes = edges_.capacity() * sizeof(Edge<Weight>) + incidence_lists_.capacity() * sizeof(IncidenceList);
+    for (const auto& incidence_list : incidence_lists_) {
+        bytes += incidence_list.capacity() * sizeof(EdgeId);
+    }
+    return bytes;
+}
 }  // namespace graph
\ No newline at end of file
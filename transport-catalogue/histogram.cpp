@@ -0,0 +1,181 @@
+#include "histogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+namespace catalogue
+{
+    namespace
+    {
+        int GetHighestBit(uint64_t value)
+        {
+            return 63 - __builtin_clzll(value);
+        }
+    }
+
+    LatencyHistogram::LatencyHistogram(int sub_bucket_bits)
+        : sub_bucket_bits_(sub_bucket_bits), sub_bucket_count_(uint64_t(1) << sub_bucket_bits), half_sub_bucket_count_(sub_bucket_count_ / 2)
+    {
+        counts_.assign(GetIndex(MAX_VALUE) + 1, 0);
+    }
+
+    size_t LatencyHistogram::GetIndex(uint64_t value) const
+    {
+        if (value < sub_bucket_count_)
+        {
+            return value;
+        }
+        // После сдвига остаются sub_bucket_bits_ старших битов: значение из [half_sub_bucket_count_, sub_bucket_count_)
+        const int shift = GetHighestBit(value) - (sub_bucket_bits_ - 1);
+        return sub_bucket_count_ + (shift - 1) * half_sub_bucket_count_ + ((value >> shift) - half_sub_bucket_count_);
+    }
+
+    uint64_t LatencyHistogram::GetHighestValue(size_t index) const
+    {
+        if (index < sub_bucket_count_)
+        {
+            return index;
+        }
+        const int shift = static_cast<int>((index - sub_bucket_count_) / half_sub_bucket_count_) + 1;
+        const uint64_t sub_bucket = (index - sub_bucket_count_) % half_sub_bucket_count_ + half_sub_bucket_count_;
+        return ((sub_bucket + 1) << shift) - 1;
+    }
+
+    void LatencyHistogram::Record(uint64_t value)
+    {
+        value = std::min(value, MAX_VALUE);
+        ++counts_[GetIndex(value)];
+        ++total_count_;
+        min_ = std::min(min_, value);
+        max_ = std::max(max_, value);
+        sum_ += static_cast<double>(value);
+        sum_of_squares_ += static_cast<double>(value) * static_cast<double>(value);
+    }
+
+    void LatencyHistogram::Merge(const LatencyHistogram &other)
+    {
+        for (size_t i = 0; i < counts_.size(); ++i)
+        {
+            counts_[i] += other.counts_[i];
+        }
+        total_count_ += other.total_count_;
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+        sum_ += other.sum_;
+        sum_of_squares_ += other.sum_of_squares_;
+    }
+
+    void LatencyHistogram::Reset()
+    {
+        *this = LatencyHistogram(sub_bucket_bits_);
+    }
+
+    uint64_t LatencyHistogram::GetCount() const
+    {
+        return total_count_;
+    }
+
+    uint64_t LatencyHistogram::GetMin() const
+    {
+        return total_count_ > 0 ? min_ : 0;
+    }
+
+    uint64_t LatencyHistogram::GetMax() const
+    {
+        return max_;
+    }
+
+    double LatencyHistogram::GetMean() const
+    {
+        return total_count_ > 0 ? sum_ / total_count_ : 0.0;
+    }
+
+    double LatencyHistogram::GetStdDeviation() const
+    {
+        if (total_count_ == 0)
+        {
+            return 0.0;
+        }
+        const double mean = GetMean();
+        return std::sqrt(std::max(0.0, sum_of_squares_ / total_count_ - mean * mean));
+    }
+
+    uint64_t LatencyHistogram::GetValueAtPercentile(double percentile) const
+    {
+        if (total_count_ == 0)
+        {
+            return 0;
+        }
+        if (percentile <= 0.0)
+        {
+            return min_;
+        }
+
+        const uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(std::min(percentile, 100.0) / 100.0 * total_count_)));
+        uint64_t cumulative = 0;
+        for (size_t i = 0; i < counts_.size(); ++i)
+        {
+            cumulative += counts_[i];
+            if (cumulative >= target)
+            {
+                return std::min(GetHighestValue(i), max_);
+            }
+        }
+        return max_;
+    }
+
+    uint64_t LatencyHistogram::GetCountAtOrBelow(uint64_t value) const
+    {
+        const size_t last = GetIndex(std::min(value, MAX_VALUE));
+        uint64_t count = 0;
+        for (size_t i = 0; i <= last; ++i)
+        {
+            count += counts_[i];
+        }
+        return count;
+    }
+
+    void LatencyHistogram::PrintPercentileDistribution(std::ostream &out, double unit_scale) const
+    {
+        const auto flags = out.flags();
+        const auto precision = out.precision();
+        out << std::fixed;
+        out << std::setw(12) << "Value" << ' ' << std::setw(14) << "Percentile" << ' ' << std::setw(10) << "TotalCount" << ' ' << std::setw(14) << "1/(1-Percentile)"
+            << "\n\n";
+
+        // Как в HdrHistogram: на каждую половину оставшегося до 100% расстояния приходится по 5 строк
+        double next_percentile = 0.0;
+        uint64_t cumulative = 0;
+        for (size_t i = 0; i < counts_.size() && total_count_ > 0; ++i)
+        {
+            if (counts_[i] == 0)
+            {
+                continue;
+            }
+            cumulative += counts_[i];
+            const double reached = 100.0 * cumulative / total_count_;
+            const double value = std::min(GetHighestValue(i), max_) / unit_scale;
+            while (next_percentile <= reached && cumulative < total_count_)
+            {
+                out << std::setprecision(3) << std::setw(12) << value << ' ' << std::setprecision(12) << std::setw(14) << next_percentile / 100.0 << ' '
+                    << std::setw(10) << cumulative << ' ' << std::setprecision(2) << std::setw(14) << 100.0 / (100.0 - next_percentile) << '\n';
+                const int half_distance = static_cast<int>(std::floor(std::log2(100.0 / (100.0 - next_percentile)))) + 1;
+                next_percentile += 100.0 / (5 * std::pow(2.0, half_distance));
+            }
+        }
+        if (total_count_ > 0)
+        {
+            out << std::setprecision(3) << std::setw(12) << max_ / unit_scale << ' ' << std::setprecision(12) << std::setw(14) << 1.0 << ' '
+                << std::setw(10) << total_count_ << '\n';
+        }
+
+        out << std::setprecision(3)
+            << "#[Mean    = " << std::setw(12) << GetMean() / unit_scale << ", StdDeviation   = " << std::setw(12) << GetStdDeviation() / unit_scale << "]\n"
+            << "#[Max     = " << std::setw(12) << max_ / unit_scale << ", Total count    = " << std::setw(12) << total_count_ << "]\n"
+            << "#[Buckets = " << std::setw(12) << (counts_.size() - sub_bucket_count_) / half_sub_bucket_count_ + 1
+            << ", SubBuckets     = " << std::setw(12) << sub_bucket_count_ << "]\n";
+        out.flags(flags);
+        out.precision(precision);
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+namespace catalogue
+{
+    /*
+     * Гистограмма задержек в наносекундах. Значения меньше 2^sub_bucket_bits хранятся точно, дальше каждый
+     * интервал [2^k, 2^(k+1)) делится на 2^(sub_bucket_bits - 1) равных частей, так что относительная
+     * погрешность не больше 2^(1 - sub_bucket_bits): около 0.1% при 11 битах, как у HdrHistogram
+     * с тремя значащими цифрами.
+     * Запись — одно увеличение счётчика без выделения памяти; гистограммы потоков сливаются через Merge
+     */
+    class LatencyHistogram
+    {
+    public:
+        // Большие значения записываются как MAX_VALUE (около 73 минут)
+        static constexpr uint64_t MAX_VALUE = (uint64_t(1) << 42) - 1;
+
+        explicit LatencyHistogram(int sub_bucket_bits = 11);
+
+        void Record(uint64_t value);
+
+        // other должна иметь ту же точность sub_bucket_bits
+        void Merge(const LatencyHistogram &other);
+
+        void Reset();
+
+        uint64_t GetCount() const;
+        uint64_t GetMin() const;
+        uint64_t GetMax() const;
+        double GetMean() const;
+        double GetStdDeviation() const;
+
+        // Наименьшее значение, не меньше которого percentile процентов записей (percentile от 0 до 100)
+        uint64_t GetValueAtPercentile(double percentile) const;
+
+        // Число записей не больше value с точностью до счётчика, в который попадает value
+        uint64_t GetCountAtOrBelow(uint64_t value) const;
+
+        // Распределение по процентилям в формате .hgrm утилит HdrHistogram; значения делятся на unit_scale
+        void PrintPercentileDistribution(std::ostream &out, double unit_scale = 1000.0) const;
+
+    private:
+        size_t GetIndex(uint64_t value) const;
+
+        // Наибольшее значение, попадающее в счётчик index
+        uint64_t GetHighestValue(size_t index) const;
+
+        int sub_bucket_bits_;
+        uint64_t sub_bucket_count_;
+        uint64_t half_sub_bucket_count_;
+        std::vector<uint64_t> counts_;
+        uint64_t total_count_ = 0;
+        uint64_t min_ = UINT64_MAX;
+        uint64_t max_ = 0;
+        double sum_ = 0.0;
+        double sum_of_squares_ = 0.0;
+    };
+}
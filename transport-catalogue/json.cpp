@@ -1,4 +1,5 @@
 #include "json.h"
+#include "memory_usage.h"
 
 namespace catalogue
 {
@@ -422,6 +423,57 @@ namespace catalogue
             return Document{LoadNode(input)};
         }
 
+        void LoadDictIncrementally(std::istream &input,
+                                   const std::function<ElementHandler(const std::string &key)> &get_element_handler,
+                                   const std::function<void(std::string key, Node value)> &on_value)
+        {
+            char c;
+            if (!(input >> c) || c != '{')
+            {
+                throw ParsingError("The root of the document is not a dictionary"s);
+            }
+
+            while (input >> c && c != '}')
+            {
+                if (c == ',')
+                {
+                    input >> c;
+                }
+
+                std::string key = LoadString(input).AsString();
+                input >> c;
+
+                const ElementHandler handler = get_element_handler(key);
+                if (!handler)
+                {
+                    on_value(std::move(key), LoadNode(input));
+                    continue;
+                }
+
+                if (!(input >> c) || c != '[')
+                {
+                    throw ParsingError("Value of "s + key + " is not an array"s);
+                }
+                while (input >> c && c != ']')
+                {
+                    if (c != ',')
+                    {
+                        input.putback(c);
+                    }
+                    handler(LoadNode(input));
+                }
+                if (!input)
+                {
+                    throw ParsingError("Сan't process the map");
+                }
+            }
+
+            if (!input)
+            {
+                throw ParsingError("Сan't process the dictionary");
+            }
+        }
+
         //------------Print------------
 
         void PrintIndent(std::ostream &out, int indent_count)
@@ -448,37 +500,43 @@ namespace catalogue
             out << (value ? "true" : "false");
         }
 
-        void PrintValue(const std::string &value, std::ostream &out, [[maybe_unused]] int indent_count)
+        void PrintEscaped(std::string_view value, std::ostream &out)
         {
-            out << '"';
-            for (const auto &ch : value)
+            size_t run_begin = 0;
+            for (size_t i = 0; i < value.size(); ++i)
             {
-
-                if (ch == '\\' || ch == '"')
-                {
-                    out << '\\';
-                }
-
-                if (ch == '\r')
-                {
-                    out << "\\r";
-                    continue;
-                }
-
-                if (ch == '\n')
+                std::string_view escaped;
+                switch (value[i])
                 {
-                    out << "\\n";
+                case '\\':
+                    escaped = "\\\\"sv;
+                    break;
+                case '"':
+                    escaped = "\\\""sv;
+                    break;
+                case '\r':
+                    escaped = "\\r"sv;
+                    break;
+                case '\n':
+                    escaped = "\\n"sv;
+                    break;
+                case '\t':
+                    escaped = "\\t"sv;
+                    break;
+                default:
                     continue;
                 }
-
-                if (ch == '\t')
-                {
-                    out << "\\t";
-                    continue;
-                }
-
-                out << ch;
+                out.write(value.data() + run_begin, i - run_begin);
+                out << escaped;
+                run_begin = i + 1;
             }
+            out.write(value.data() + run_begin, value.size() - run_begin);
+        }
+
+        void PrintValue(const std::string &value, std::ostream &out, [[maybe_unused]] int indent_count)
+        {
+            out << '"';
+            PrintEscaped(value, out);
             out << '"';
         }
 
@@ -526,11 +584,130 @@ namespace catalogue
             out << "}";
         }
 
+        size_t GetMemoryUsage(const Node &node)
+        {
+            if (node.IsString())
+            {
+                return GetHeapBytes(node.AsString());
+            }
+            if (node.IsArray())
+            {
+                const Array &array = node.AsArray();
+                size_t bytes = array.capacity() * sizeof(Node);
+                for (const Node &element : array)
+                {
+                    bytes += GetMemoryUsage(element);
+                }
+                return bytes;
+            }
+            if (node.IsMap())
+            {
+                return GetMemoryUsage(node.AsMap());
+            }
+            return 0;
+        }
+
+        size_t GetMemoryUsage(const Dict &dict)
+        {
+            size_t bytes = 0;
+            for (const auto &[key, value] : dict)
+            {
+                bytes += TREE_NODE_OVERHEAD + sizeof(Dict::value_type) + GetHeapBytes(key) + GetMemoryUsage(value);
+            }
+            return bytes;
+        }
+
+        size_t GetMemoryUsage(const Document &doc)
+        {
+            return sizeof(Node) + GetMemoryUsage(doc.GetRoot());
+        }
+
         void Print(const Document &doc, std::ostream &output)
         {
-            int indent_count = 0;
+            PrintNode(doc.GetRoot(), output, 0);
+        }
+
+        void PrintNode(const Node &node, std::ostream &output, int indent_count)
+        {
             std::visit([&output, &indent_count](const auto &value)
-                       { PrintValue(value, output, indent_count); }, doc.GetRoot().GetValue());
+                       { PrintValue(value, output, indent_count); }, node.GetValue());
+        }
+
+        void PrintCompact(const Node &node, std::ostream &output)
+        {
+            if (node.IsArray())
+            {
+                output << '[';
+                bool is_first = true;
+                for (const auto &elem : node.AsArray())
+                {
+                    if (!is_first)
+                    {
+                        output << ',';
+                    }
+                    PrintCompact(elem, output);
+                    is_first = false;
+                }
+                output << ']';
+            }
+            else if (node.IsMap())
+            {
+                output << '{';
+                bool is_first = true;
+                for (const auto &[key, value] : node.AsMap())
+                {
+                    if (!is_first)
+                    {
+                        output << ',';
+                    }
+                    output << '"';
+                    PrintEscaped(key, output);
+                    output << "\":"sv;
+                    PrintCompact(value, output);
+                    is_first = false;
+                }
+                output << '}';
+            }
+            else
+            {
+                PrintNode(node, output, 0);
+            }
+        }
+
+        //------------EscapingStreamBuf------------
+
+        EscapingStreamBuf::EscapingStreamBuf(std::ostream &out)
+            : out_(out)
+        {
+            setp(buffer_.data(), buffer_.data() + buffer_.size());
+        }
+
+        EscapingStreamBuf::~EscapingStreamBuf()
+        {
+            FlushBuffer();
+        }
+
+        EscapingStreamBuf::int_type EscapingStreamBuf::overflow(int_type ch)
+        {
+            FlushBuffer();
+            if (!traits_type::eq_int_type(ch, traits_type::eof()))
+            {
+                *pptr() = traits_type::to_char_type(ch);
+                pbump(1);
+            }
+            return traits_type::not_eof(ch);
+        }
+
+        int EscapingStreamBuf::sync()
+        {
+            FlushBuffer();
+            return out_ ? 0 : -1;
+        }
+
+        void EscapingStreamBuf::FlushBuffer()
+        {
+            PrintEscaped({pbase(), static_cast<size_t>(pptr() - pbase())}, out_);
+            setp(buffer_.data(), buffer_.data() + buffer_.size());
         }
 
     } // namespace json
@@ -1,7 +1,11 @@
 #pragma once
+#include <array>
+#include <functional>
 #include <iostream>
 #include <map>
+#include <streambuf>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 
@@ -70,7 +74,61 @@ namespace catalogue
 
         Document Load(std::istream &input);
 
+        // Память в куче, на которую ссылается узел: строки, элементы массивов и словарей со всем их содержимым
+        size_t GetMemoryUsage(const Node &node);
+
+        size_t GetMemoryUsage(const Dict &dict);
+
+        // Память дерева документа вместе с корнем
+        size_t GetMemoryUsage(const Document &doc);
+
+        using ElementHandler = std::function<void(Node element)>;
+
+        /*
+         * Читает документ, корнем которого является словарь, по одной паре ключ-значение.
+         * Если get_element_handler вернул обработчик для ключа, массив под этим ключом не собирается целиком:
+         * каждый элемент передаётся обработчику сразу после разбора. Остальные значения передаются в on_value
+         */
+        void LoadDictIncrementally(std::istream &input,
+                                   const std::function<ElementHandler(const std::string &key)> &get_element_handler,
+                                   const std::function<void(std::string key, Node value)> &on_value);
+
         void Print(const Document &doc, std::ostream &output);
 
+        // Выводит узел так же, как Print выводит вложенные значения на уровне отступа indent_count
+        void PrintNode(const Node &node, std::ostream &output, int indent_count);
+
+        void PrintIndent(std::ostream &out, int indent_count);
+
+        // Выводит узел в одну строку без пробелов и переводов строк
+        void PrintCompact(const Node &node, std::ostream &output);
+
+        // Выводит содержимое строки с экранированием, но без обрамляющих кавычек
+        void PrintEscaped(std::string_view value, std::ostream &out);
+
+        /*
+         * Буфер потока, экранирующий всё, что в него записывают, как содержимое JSON-строки.
+         * Позволяет выводить большую строку прямо в ответ, не собирая её целиком в памяти
+         */
+        class EscapingStreamBuf : public std::streambuf
+        {
+        public:
+            explicit EscapingStreamBuf(std::ostream &out);
+            ~EscapingStreamBuf() override;
+
+            EscapingStreamBuf(const EscapingStreamBuf &) = delete;
+            EscapingStreamBuf &operator=(const EscapingStreamBuf &) = delete;
+
+        protected:
+            int_type overflow(int_type ch) override;
+            int sync() override;
+
+        private:
+            void FlushBuffer();
+
+            std::ostream &out_;
+            std::array<char, 4096> buffer_;
+        };
+
     } // namespace json
 } // namespace catalogue
\ No newline at end of file
@@ -1,8 +1,13 @@
 #include "json_reader.h"
 #include "json_builder.h"
+#include "metrics.h"
 
-#include <set>
+#include <algorithm>
+#include <array>
+#include <limits>
 #include <sstream>
+#include <stdexcept>
+#include <variant>
 
 namespace catalogue
 {
@@ -12,6 +17,7 @@ namespace catalogue
 
         void ParseRequests(const Document &doc, TransportCatalogue &catalogue, std::vector<StatRequests> &stat_requests, renderer::RenderSettings &rend_sett, router::RouterSettings &rout_sett)
         {
+            metrics::ScopedTimer timer(metrics::RecordPhase, "parse");
             const auto &root = doc.GetRoot();
             if (root.IsMap())
             {
@@ -129,6 +135,20 @@ namespace catalogue
             {
                 color_pal.push_back(std::move(ParseColor(color)));
             }
+
+            if (const auto it = dictionary.find("level_of_detail"); it != dictionary.end())
+            {
+                const auto &lod = it->second.AsMap();
+                rend_sett.lod_tolerance = lod.at("tolerance").AsDouble();
+                rend_sett.lod_cell_size = lod.at("cell_size").AsDouble();
+            }
+
+            if (const auto it = dictionary.find("compact_output"); it != dictionary.end())
+            {
+                const auto &compact = it->second.AsMap();
+                const auto precision = compact.find("precision");
+                rend_sett.compact_precision = precision != compact.end() ? precision->second.AsInt() : svg::CompactFormat{}.precision;
+            }
         }
 
         void ParseRouteSettings(const Node &node, router::RouterSettings &rout_sett)
@@ -141,23 +161,133 @@ namespace catalogue
             const auto &dictionary = node.AsMap();
             rout_sett.bus_velocity = dictionary.at("bus_velocity").AsDouble();
             rout_sett.wait_time = dictionary.at("bus_wait_time").AsDouble();
+            if (const auto it = dictionary.find("route_cache_size"); it != dictionary.end())
+            {
+                rout_sett.route_cache_size = it->second.AsInt();
+            }
+            if (const auto it = dictionary.find("engine"); it != dictionary.end())
+            {
+                const std::string &engine = it->second.AsString();
+                if (engine == "alt")
+                {
+                    rout_sett.engine = router::RouterEngine::ALT;
+                }
+                else if (engine != "all_pairs")
+                {
+                    std::cerr << "Error: unknown routing engine "sv << engine << std::endl;
+                }
+            }
+            if (const auto it = dictionary.find("landmarks"); it != dictionary.end())
+            {
+                rout_sett.landmark_count = std::max(it->second.AsInt(), 0);
+            }
+            if (const auto it = dictionary.find("integer_weights"); it != dictionary.end())
+            {
+                rout_sett.integer_weights = it->second.AsBool();
+            }
+            if (const auto it = dictionary.find("huge_pages"); it != dictionary.end())
+            {
+                rout_sett.huge_pages = it->second.AsBool();
+            }
         }
 
-        StatRequests ParseCommandDescription(const Node &node)
+        // Область карты из запроса Map. Перевёрнутые границы и несуществующий тайл — ошибка запроса
+        std::optional<geo::BoundingBox> ParseViewport(const Dict &dict)
         {
-            const auto &dict = node.AsMap();
-            const auto &type = dict.at("type").AsString();
-            if (type == "Map")
+            // Больше 2^30 тайлов по стороне номер тайла не помещается в int
+            constexpr int MAX_TILE_ZOOM = 30;
+
+            if (const auto it = dict.find("viewport"); it != dict.end())
             {
-                return {dict.at("id").AsInt(), type, "", "", ""};
+                const auto &viewport = it->second.AsMap();
+                const geo::BoundingBox box{{viewport.at("min_lat").AsDouble(), viewport.at("min_lng").AsDouble()},
+                                           {viewport.at("max_lat").AsDouble(), viewport.at("max_lng").AsDouble()}};
+                if (!(box.min.lat <= box.max.lat) || !(box.min.lng <= box.max.lng))
+                {
+                    throw RequestError("bad request");
+                }
+                return box;
             }
 
-            if (type == "Route")
+            if (const auto it = dict.find("tile"); it != dict.end())
             {
-                return {dict.at("id").AsInt(), type, "", dict.at("from").AsString(), dict.at("to").AsString()};
+                const auto &tile = it->second.AsMap();
+                const int zoom = tile.at("z").AsInt();
+                const int x = tile.at("x").AsInt();
+                const int y = tile.at("y").AsInt();
+                if (zoom < 0 || zoom > MAX_TILE_ZOOM)
+                {
+                    throw RequestError("bad request");
+                }
+                const int tiles = 1 << zoom;
+                if (x < 0 || x >= tiles || y < 0 || y >= tiles)
+                {
+                    throw RequestError("bad request");
+                }
+                return geo::TileToBoundingBox(zoom, x, y);
             }
 
-            return {dict.at("id").AsInt(), type, dict.at("name").AsString(), "", ""};
+            return std::nullopt;
+        }
+
+        StatRequests ParseCommandDescription(const Node &node)
+        {
+            try
+            {
+                const auto &dict = node.AsMap();
+                const auto &type = dict.at("type").AsString();
+                if (type == "Map")
+                {
+                    StatRequests request{dict.at("id").AsInt(), type, "", "", ""};
+                    request.viewport = ParseViewport(dict);
+                    return request;
+                }
+
+                if (type == "Stats" || type == "Memory")
+                {
+                    return {dict.at("id").AsInt(), type, "", "", ""};
+                }
+
+                if (type == "Route")
+                {
+                    StatRequests request{dict.at("id").AsInt(), type, "", dict.at("from").AsString(), dict.at("to").AsString()};
+                    if (const auto it = dict.find("departure_time"); it != dict.end())
+                    {
+                        request.departure_time = ParseTime(it->second);
+                    }
+                    if (const auto it = dict.find("alternatives"); it != dict.end())
+                    {
+                        request.alternatives = it->second.AsInt();
+                    }
+                    return request;
+                }
+
+                if (type == "Search")
+                {
+                    StatRequests request{dict.at("id").AsInt(), type, dict.at("query").AsString(), "", ""};
+                    if (const auto it = dict.find("limit"); it != dict.end())
+                    {
+                        request.limit = it->second.AsInt();
+                    }
+                    if (const auto it = dict.find("max_distance"); it != dict.end())
+                    {
+                        request.max_distance = it->second.AsInt();
+                    }
+                    return request;
+                }
+
+                return {dict.at("id").AsInt(), type, dict.at("name").AsString(), "", ""};
+            }
+            // Нет обязательного поля (out_of_range из Dict::at) или поле не того типа (logic_error и bad_variant_access
+            // из Node::As*, invalid_argument из разбора времени) — запрос составлен неверно
+            catch (const std::logic_error &)
+            {
+                throw RequestError("bad request");
+            }
+            catch (const std::bad_variant_access &)
+            {
+                throw RequestError("bad request");
+            }
         }
 
         void ParseStatRequest(const Node &node, std::vector<StatRequests> &stat_requests)
@@ -189,12 +319,70 @@ namespace catalogue
             return route;
         }
 
+        double ParseTime(const Node &node)
+        {
+            if (!node.IsString())
+            {
+                return node.AsDouble();
+            }
+
+            const std::string &time = node.AsString();
+            const size_t colon = time.find(':');
+            if (colon == std::string::npos)
+            {
+                throw ParsingError("Time should be in HH:MM format: "s + time);
+            }
+            return std::stoi(time.substr(0, colon)) * 60.0 + std::stoi(time.substr(colon + 1));
+        }
+
+        // Отправления с первой остановки: список "timetable" или интервальное движение "frequency"
+        std::vector<double> ParseDepartures(const Dict &dict)
+        {
+            std::vector<double> departures;
+            if (const auto it = dict.find("timetable"); it != dict.end())
+            {
+                for (const auto &time : it->second.AsArray())
+                {
+                    departures.push_back(ParseTime(time));
+                }
+                std::sort(departures.begin(), departures.end());
+            }
+            else if (const auto it = dict.find("frequency"); it != dict.end())
+            {
+                const auto &frequency = it->second.AsMap();
+                const double last_departure = ParseTime(frequency.at("last_departure"));
+                const double interval = frequency.at("interval").AsDouble();
+                if (interval <= 0)
+                {
+                    throw ParsingError("Bus frequency interval should be positive"s);
+                }
+                for (double departure = ParseTime(frequency.at("first_departure")); departure <= last_departure; departure += interval)
+                {
+                    departures.push_back(departure);
+                }
+            }
+            return departures;
+        }
+
+        // Запрос ссылается на остановку, которой нет в справочнике
+        void CheckStopExists(const TransportCatalogue &catalogue, std::string_view name)
+        {
+            if (catalogue.FindStop(name) == nullptr)
+            {
+                throw RequestError("not found");
+            }
+        }
+
         void ParseBusRequest(const Dict &dict, TransportCatalogue &catalogue)
         {
             const bool is_roundtrip = dict.at("is_roundtrip").AsBool();
             std::vector<std::string_view> stops = ParseRoute(dict.at("stops").AsArray(), is_roundtrip);
+            for (const std::string_view stop : stops)
+            {
+                CheckStopExists(catalogue, stop);
+            }
 
-            catalogue.AddBus(dict.at("name").AsString(), stops, is_roundtrip);
+            catalogue.AddBus(dict.at("name").AsString(), stops, is_roundtrip, ParseDepartures(dict));
         }
 
         void ParseStopRequest(const Dict &dict, TransportCatalogue &catalogue)
@@ -208,59 +396,66 @@ namespace catalogue
         {
             for (const auto &[other_stop, node] : dict.at("road_distances").AsMap())
             {
+                CheckStopExists(catalogue, other_stop);
                 catalogue.SetDistance(dict.at("name").AsString(), other_stop, node.AsInt());
             }
         }
 
         void ParseBaseRequest(const Node &node, TransportCatalogue &catalogue)
         {
-            if (!node.IsArray())
+            try
             {
-                std::cerr << "Error: content of base_requests is not a array"sv;
-            }
-
-            const auto &array = node.AsArray();
-            for (const auto &req : array)
-            {
-                const Dict &dict = req.AsMap();
-                std::string_view req_type = dict.at("type").AsString();
-
-                if (req_type == "Stop"sv)
+                if (!node.IsArray())
                 {
-                    ParseStopRequest(dict, catalogue);
+                    std::cerr << "Error: content of base_requests is not a array"sv;
                 }
-            }
 
-            for (const auto &req : array)
-            {
-                const Dict &dict = req.AsMap();
-                std::string_view req_type = dict.at("type").AsString();
-
-                if (req_type == "Stop"sv)
+                const auto &array = node.AsArray();
+                for (const auto &req : array)
                 {
-                    ParseStopDistance(dict, catalogue);
+                    const Dict &dict = req.AsMap();
+                    std::string_view req_type = dict.at("type").AsString();
+
+                    if (req_type == "Stop"sv)
+                    {
+                        ParseStopRequest(dict, catalogue);
+                    }
                 }
-            }
 
-            for (const auto &req : array)
-            {
-                const Dict &dict = req.AsMap();
-                std::string_view req_type = dict.at("type").AsString();
+                for (const auto &req : array)
+                {
+                    const Dict &dict = req.AsMap();
+                    std::string_view req_type = dict.at("type").AsString();
+
+                    if (req_type == "Stop"sv)
+                    {
+                        ParseStopDistance(dict, catalogue);
+                    }
+                }
 
-                if (req_type == "Bus"sv)
+                for (const auto &req : array)
                 {
-                    ParseBusRequest(dict, catalogue);
+                    const Dict &dict = req.AsMap();
+                    std::string_view req_type = dict.at("type").AsString();
+
+                    if (req_type == "Bus"sv)
+                    {
+                        ParseBusRequest(dict, catalogue);
+                    }
                 }
-            }
-        }
 
-        struct BusPtrComparator
-        {
-            bool operator()(const Bus *left, const Bus *right) const
+                catalogue.BuildStopIndex();
+            }
+            // Как и в ParseCommandDescription, ошибки в полях запроса сообщаются клиенту как "bad request"
+            catch (const std::logic_error &)
+            {
+                throw RequestError("bad request");
+            }
+            catch (const std::bad_variant_access &)
             {
-                return left->bus_name < right->bus_name;
+                throw RequestError("bad request");
             }
-        };
+        }
 
         void GetStopInfo(RequestHandler &request_handler, std::string_view name, json::Builder &json_builder)
         {
@@ -272,9 +467,7 @@ namespace catalogue
 
             json_builder.Key("buses").StartArray();
 
-            const auto &buses = request_handler.GetStopInfo(name);
-            const std::set<const Bus *, BusPtrComparator> sorted_buses(buses.begin(), buses.end());
-            for (const auto &bus : sorted_buses)
+            for (const Bus *bus : request_handler.GetStopInfo(name))
             {
                 json_builder.Value(bus->bus_name);
             }
@@ -302,30 +495,31 @@ namespace catalogue
                 .Value(bus_info.unique_stops);
         }
 
-        void GetMap(RequestHandler &request_handler, json::Builder &json_builder)
+        void RenderMap(RequestHandler &request_handler, const std::optional<geo::BoundingBox> &viewport, std::ostream &out)
+        {
+            if (viewport)
+            {
+                request_handler.RenderMap(out, *viewport);
+            }
+            else
+            {
+                request_handler.RenderMap(out);
+            }
+        }
+
+        void GetMap(RequestHandler &request_handler, const std::optional<geo::BoundingBox> &viewport, json::Builder &json_builder)
         {
             std::ostringstream out;
-            svg::Document output = request_handler.RenderMap();
-            output.Render(out);
+            RenderMap(request_handler, viewport, out);
 
             json_builder.Key("map").Value(out.str());
         }
 
-        void GetRouteInfo(RequestHandler &request_handler, json::Builder &json_builder, std::string_view from, std::string_view to)
+        void AddRouteItems(const RequestHandler::RouteInfo &route_info, json::Builder &json_builder)
         {
-            const Stop *stop_from = request_handler.FindStop(from);
-            const Stop *stop_to = request_handler.FindStop(to);
-            const auto &route_info = request_handler.GetShortestRoute(stop_from, stop_to);
-
-            if (!route_info)
-            {
-                json_builder.Key("error_message").Value("not found");
-                return;
-            }
-
             json_builder.Key("items").StartArray();
             double total_time = 0.0;
-            for (const auto &edge : route_info.value())
+            for (const auto &edge : route_info)
             {
                 json_builder.StartDict();
                 if (edge.span_count == 0)
@@ -358,39 +552,294 @@ namespace catalogue
             json_builder.Key("total_time").Value(total_time);
         }
 
+        // Лучший маршрут выводится в items и total_time, остальные — в массиве alternatives
+        void GetAlternativeRoutesInfo(RequestHandler &request_handler, json::Builder &json_builder, const Stop *from, const Stop *to, int count)
+        {
+            const auto routes = request_handler.GetAlternativeRoutes(from, to, count);
+            if (routes.empty())
+            {
+                json_builder.Key("error_message").Value("not found");
+                return;
+            }
+
+            AddRouteItems(routes.front(), json_builder);
+            json_builder.Key("alternatives").StartArray();
+            for (size_t i = 1; i < routes.size(); ++i)
+            {
+                json_builder.StartDict();
+                AddRouteItems(routes[i], json_builder);
+                json_builder.EndDict();
+            }
+            json_builder.EndArray();
+        }
+
+        void GetRouteInfo(RequestHandler &request_handler, json::Builder &json_builder, const StatRequests &request)
+        {
+            const Stop *stop_from = request_handler.FindStop(request.from);
+            const Stop *stop_to = request_handler.FindStop(request.to);
+            if (stop_from == nullptr || stop_to == nullptr)
+            {
+                json_builder.Key("error_message").Value("not found");
+                return;
+            }
+            if (request.alternatives && (*request.alternatives < 1 || request.departure_time))
+            {
+                json_builder.Key("error_message").Value("bad request");
+                return;
+            }
+            if (request.alternatives)
+            {
+                GetAlternativeRoutesInfo(request_handler, json_builder, stop_from, stop_to, *request.alternatives);
+                return;
+            }
+
+            const auto &route_info = request.departure_time ? request_handler.GetEarliestArrivalRoute(stop_from, stop_to, *request.departure_time)
+                                                            : request_handler.GetShortestRoute(stop_from, stop_to);
+            if (!route_info)
+            {
+                json_builder.Key("error_message").Value("not found");
+                return;
+            }
+
+            AddRouteItems(*route_info, json_builder);
+        }
+
+        void GetSearchInfo(RequestHandler &request_handler, const StatRequests &request, json::Builder &json_builder)
+        {
+            json_builder.Key("items").StartArray();
+            for (const auto &match : request_handler.FindNames(request.name, request.max_distance, std::max(request.limit, 0)))
+            {
+                json_builder
+                    .StartDict()
+                    .Key("type")
+                    .Value(match.kind == NameIndex::Kind::STOP ? "Stop" : "Bus")
+                    .Key("name")
+                    .Value(std::string(match.name))
+                    .Key("distance")
+                    .Value(match.distance)
+                    .EndDict();
+            }
+            json_builder.EndArray();
+        }
+
+        void GetStats(RequestHandler &request_handler, json::Builder &json_builder)
+        {
+            const auto to_microseconds = [](uint64_t nanoseconds)
+            {
+                return nanoseconds / 1000.0;
+            };
+
+            const metrics::Snapshot snapshot = request_handler.GetStats();
+            json_builder.Key("requests").StartDict();
+            for (const auto &[type, histogram] : snapshot.requests)
+            {
+                json_builder.Key(type)
+                    .StartDict()
+                    .Key("count")
+                    .Value(static_cast<int>(histogram.GetCount()))
+                    .Key("mean_us")
+                    .Value(histogram.GetMean() / 1000.0)
+                    .Key("p50_us")
+                    .Value(to_microseconds(histogram.GetValueAtPercentile(50)))
+                    .Key("p95_us")
+                    .Value(to_microseconds(histogram.GetValueAtPercentile(95)))
+                    .Key("p99_us")
+                    .Value(to_microseconds(histogram.GetValueAtPercentile(99)))
+                    .Key("max_us")
+                    .Value(to_microseconds(histogram.GetMax()))
+                    .EndDict();
+            }
+            json_builder.EndDict();
+
+            json_builder.Key("phases").StartDict();
+            for (const auto &[phase, histogram] : snapshot.phases)
+            {
+                json_builder.Key(phase)
+                    .StartDict()
+                    .Key("count")
+                    .Value(static_cast<int>(histogram.GetCount()))
+                    .Key("total_ms")
+                    .Value(histogram.GetMean() * histogram.GetCount() / 1e6)
+                    .Key("max_ms")
+                    .Value(histogram.GetMax() / 1e6)
+                    .EndDict();
+            }
+            json_builder.EndDict();
+
+            const auto &cache = snapshot.route_cache;
+            const uint64_t lookups = cache.hits + cache.misses;
+            json_builder.Key("route_cache")
+                .StartDict()
+                .Key("hits")
+                .Value(static_cast<int>(cache.hits))
+                .Key("misses")
+                .Value(static_cast<int>(cache.misses))
+                .Key("size")
+                .Value(static_cast<int>(cache.size))
+                .Key("hit_rate")
+                .Value(lookups > 0 ? static_cast<double>(cache.hits) / lookups : 0.0)
+                .EndDict();
+        }
+
+        void GetMemoryInfo(RequestHandler &request_handler, json::Builder &json_builder)
+        {
+            // Целые узлы ограничены int, поэтому больше 2 ГБ выводится дробным числом
+            const auto to_node = [](size_t bytes)
+            {
+                return bytes <= static_cast<size_t>(std::numeric_limits<int>::max()) ? Node::Value(static_cast<int>(bytes)) : Node::Value(static_cast<double>(bytes));
+            };
+
+            const MemoryUsage usage = request_handler.GetMemoryUsage();
+            json_builder.Key("total_bytes").Value(to_node(usage.GetTotal()));
+            json_builder.Key("structures").StartDict();
+            for (const auto &[name, bytes] : usage.items)
+            {
+                json_builder.Key(name).Value(to_node(bytes));
+            }
+            json_builder.EndDict();
+        }
+
+        // Вид запроса для метрик. Неизвестные виды собираются под меткой "other": иначе каждый новый вид
+        // от клиента заводил бы в каждом потоке свою гистограмму, которая живёт до конца работы
+        std::string_view GetRequestMetricsLabel(std::string_view type)
+        {
+            static constexpr std::array KNOWN_TYPES{"Stop"sv, "Bus"sv, "Map"sv, "Route"sv, "Search"sv, "Stats"sv, "Memory"sv};
+            return std::find(KNOWN_TYPES.begin(), KNOWN_TYPES.end(), type) != KNOWN_TYPES.end() ? type : "other"sv;
+        }
+
+        void AddResponse(RequestHandler &request_handler, const StatRequests &request, json::Builder &json_builder)
+        {
+            metrics::ScopedTimer timer(metrics::RecordRequest, GetRequestMetricsLabel(request.type));
+            const auto &[id, type, name, from, to, viewport, departure_time, alternatives, limit, max_distance] = request;
+            json_builder.StartDict().Key("request_id").Value(id);
+            if (type == "Stop")
+            {
+                GetStopInfo(request_handler, name, json_builder);
+            }
+
+            if (type == "Bus")
+            {
+                GetBusInfo(request_handler, name, json_builder);
+            }
+
+            if (type == "Map")
+            {
+                GetMap(request_handler, viewport, json_builder);
+            }
+
+            if (type == "Route")
+            {
+                GetRouteInfo(request_handler, json_builder, request);
+            }
+
+            if (type == "Search")
+            {
+                GetSearchInfo(request_handler, request, json_builder);
+            }
+
+            if (type == "Stats")
+            {
+                GetStats(request_handler, json_builder);
+            }
+
+            if (type == "Memory")
+            {
+                GetMemoryInfo(request_handler, json_builder);
+            }
+
+            json_builder.EndDict();
+        }
+
+        std::string GetErrorMessage(const std::exception &error)
+        {
+            if (const auto *request_error = dynamic_cast<const RequestError *>(&error))
+            {
+                return request_error->what();
+            }
+            if (dynamic_cast<const ParsingError *>(&error))
+            {
+                return "bad request"s;
+            }
+            return "internal error"s;
+        }
+
+        Node GetErrorResponse(int request_id, const std::exception &error)
+        {
+            return json::Builder{}.StartDict().Key("request_id").Value(request_id).Key("error_message").Value(GetErrorMessage(error)).EndDict().Build();
+        }
+
+        Node GetResponse(RequestHandler &request_handler, const StatRequests &request)
+        {
+            json::Builder json_builder;
+            AddResponse(request_handler, request, json_builder);
+            return json_builder.Build();
+        }
+
         Document GetOutputDocument(RequestHandler &request_handler, std::vector<StatRequests> &stat_requests)
         {
             json::Builder json_builder;
             json_builder.StartArray();
 
-            for (const auto &[id, type, name, from, to] : stat_requests)
+            for (const auto &request : stat_requests)
             {
-                json_builder.StartDict().Key("request_id").Value(id);
-                if (type == "Stop")
-                {
-                    GetStopInfo(request_handler, name, json_builder);
-                }
+                AddResponse(request_handler, request, json_builder);
+            }
 
-                if (type == "Bus")
-                {
-                    GetBusInfo(request_handler, name, json_builder);
-                }
+            json_builder.EndArray();
+            return Document{json_builder.Build()};
+        }
 
-                if (type == "Map")
-                {
-                    GetMap(request_handler, json_builder);
-                }
+        void PrintMapResponse(RequestHandler &request_handler, const StatRequests &request, std::ostream &out)
+        {
+            metrics::ScopedTimer timer(metrics::RecordRequest, "Map"sv);
+            out << "{\n"sv;
+            PrintIndent(out, 2);
+            out << "\"map\": \""sv;
+            {
+                EscapingStreamBuf escaping_buf(out);
+                std::ostream escaped_out(&escaping_buf);
+                RenderMap(request_handler, request.viewport, escaped_out);
+            }
+            out << "\",\n"sv;
+            PrintIndent(out, 2);
+            out << "\"request_id\": "sv << request.id << '\n';
+            PrintIndent(out, 1);
+            out << '}';
+        }
 
-                if (type == "Route")
-                {
-                    GetRouteInfo(request_handler, json_builder, from, to);
-                }
+        void PrintResponse(RequestHandler &request_handler, const StatRequests &request, std::ostream &out)
+        {
+            if (request.type == "Map")
+            {
+                PrintMapResponse(request_handler, request, out);
+                return;
+            }
 
-                json_builder.EndDict();
+            Node response;
+            try
+            {
+                response = GetResponse(request_handler, request);
             }
+            catch (const std::exception &e)
+            {
+                // Ответ на остальные запросы не должен пропадать из-за запроса, который не удалось выполнить
+                response = GetErrorResponse(request.id, e);
+            }
+            PrintNode(response, out, 1);
+        }
 
-            json_builder.EndArray();
-            return Document{json_builder.Build()};
+        void PrintOutput(RequestHandler &request_handler, const std::vector<StatRequests> &stat_requests, std::ostream &out)
+        {
+            out << '[';
+            bool is_first = true;
+            for (const auto &request : stat_requests)
+            {
+                out << (is_first ? "\n"sv : ",\n"sv);
+                PrintIndent(out, 1);
+                PrintResponse(request_handler, request, out);
+                is_first = false;
+            }
+            out << "\n]"sv;
         }
 
     } // namespace json
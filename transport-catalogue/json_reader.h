@@ -5,10 +5,19 @@
 #include "request_handler.h"
 #include "transport_catalogue.h"
 
+#include <stdexcept>
+
 namespace catalogue
 {
     namespace json
     {
+        // Ошибка в запросе клиента; what() — сообщение для ответа: "bad request" или "not found"
+        class RequestError : public std::runtime_error
+        {
+        public:
+            using runtime_error::runtime_error;
+        };
+
         struct StatRequests
         {
             int id;
@@ -16,6 +25,16 @@ namespace catalogue
             std::string name;
             std::string from;
             std::string to;
+            // Область карты для запроса Map; если не задана, выводится вся карта
+            std::optional<geo::BoundingBox> viewport = std::nullopt;
+            // Время отправления для запроса Route в минутах от начала суток; если задано, маршрут ищется по расписанию
+            std::optional<double> departure_time = std::nullopt;
+            // Сколько маршрутов вывести в запросе Route: лучший и до alternatives - 1 запасных. Должно быть не меньше 1;
+            // вместе с departure_time не поддерживается, на такие запросы выводится "bad request"
+            std::optional<int> alternatives = std::nullopt;
+            // Запрос Search: в name — начало названия, не больше limit ответов, допустимое число правок max_distance
+            int limit = 10;
+            int max_distance = 0;
         };
 
         void ParseRequests(const Document &doc, TransportCatalogue &catalogue, std::vector<StatRequests> &stat_requests, renderer::RenderSettings &rend_sett, router::RouterSettings &rout_sett);
@@ -24,14 +43,40 @@ namespace catalogue
 
         void ParseBaseRequest(const Node &node, TransportCatalogue &catalogue);
 
+        // Время в минутах от начала суток: число минут или строка "ЧЧ:ММ"
+        double ParseTime(const Node &node);
+
         void ParseStatRequest(const Node &node, std::vector<StatRequests> &stat_requests);
 
+        // Разбирает описание одного запроса из stat_requests
+        StatRequests ParseCommandDescription(const Node &node);
+
         void ParseRenderSettings(const Node &node, renderer::RenderSettings &rend_sett);
 
         void ParseRouteSettings(const Node &node, router::RouterSettings &rout_sett);
 
         svg::Color ParseColor(const Node &node);
 
+        // Сообщение об ошибке для клиента: текст RequestError, "bad request" для неразобранного JSON, иначе "internal error".
+        // Текст прочих исключений наружу не выдаётся: они означают ошибку сервера, а не запроса
+        std::string GetErrorMessage(const std::exception &error);
+
+        // Ответ вместо того, который не удалось получить: request_id и error_message
+        Node GetErrorResponse(int request_id, const std::exception &error);
+
+        // Ответ на один запрос в том же виде, что и элемент массива GetOutputDocument
+        Node GetResponse(RequestHandler &request_handler, const StatRequests &request);
+
         Document GetOutputDocument(RequestHandler &request_handler, std::vector<StatRequests> &stat_requests);
+
+        // Выводит ответ на один запрос на уровне вложенности элемента массива ответов. Если ответ получить
+        // не удалось, выводится GetErrorResponse. Исключение при выводе карты не перехватывается: карта пишется
+        // в out по мере отрисовки, и начатый вывод уже не заменить
+        void PrintResponse(RequestHandler &request_handler, const StatRequests &request, std::ostream &out);
+
+        // Выводит ответы по мере их получения, не собирая общий Document.
+        // Карта экранируется и попадает в поток без промежуточных копий.
+        // Результат совпадает с выводом Print(GetOutputDocument(...))
+        void PrintOutput(RequestHandler &request_handler, const std::vector<StatRequests> &stat_requests, std::ostream &out);
     }
 }
\ No newline at end of file
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "memory_usage.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+
+namespace catalogue
+{
+    /*
+     * Кэш ограниченного размера с вытеснением давно не использованных записей.
+     * Записи распределены по SHARD_COUNT частям со своими блокировками, чтобы потоки,
+     * обращающиеся к разным ключам, как правило не ждали друг друга
+     */
+    template <typename Key, typename Value, typename Hash = std::hash<Key>>
+    class ShardedLruCache
+    {
+    public:
+        struct Stats
+        {
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+            size_t size = 0;
+        };
+
+        static const size_t SHARD_COUNT = 16;
+
+        // Ёмкость делится между частями поровну; при нулевой ёмкости кэш ничего не хранит
+        explicit ShardedLruCache(size_t capacity)
+            : shard_capacity_((capacity + SHARD_COUNT - 1) / SHARD_COUNT) {}
+
+        std::optional<Value> Get(const Key &key)
+        {
+            Shard &shard = GetShard(key);
+            std::lock_guard lock(shard.mutex);
+            const auto it = shard.index.find(key);
+            if (it == shard.index.end())
+            {
+                misses_.fetch_add(1, std::memory_order_relaxed);
+                return std::nullopt;
+            }
+
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+            return it->second->second;
+        }
+
+        void Put(const Key &key, Value value)
+        {
+            if (shard_capacity_ == 0)
+            {
+                return;
+            }
+
+            Shard &shard = GetShard(key);
+            std::lock_guard lock(shard.mutex);
+            if (const auto it = shard.index.find(key); it != shard.index.end())
+            {
+                it->second->second = std::move(value);
+                shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+                return;
+            }
+
+            shard.entries.emplace_front(key, std::move(value));
+            shard.index.emplace(key, shard.entries.begin());
+            if (shard.entries.size() > shard_capacity_)
+            {
+                shard.index.erase(shard.entries.back().first);
+                shard.entries.pop_back();
+            }
+        }
+
+        void Clear()
+        {
+            for (auto &shard : shards_)
+            {
+                std::lock_guard lock(shard.mutex);
+                shard.index.clear();
+                shard.entries.clear();
+            }
+        }
+
+        // Узлы списков и хеш-таблиц вместе с памятью, на которую ссылаются значения
+        size_t GetMemoryUsage() const
+        {
+            size_t bytes = 0;
+            for (const auto &shard : shards_)
+            {
+                std::lock_guard lock(shard.mutex);
+                bytes += shard.entries.size() * (LIST_NODE_OVERHEAD + sizeof(std::pair<Key, Value>));
+                bytes += shard.index.size() * (HASH_NODE_OVERHEAD + sizeof(typename decltype(shard.index)::value_type));
+                bytes += shard.index.bucket_count() * sizeof(void *);
+                if constexpr (!std::is_trivially_copyable_v<Value>)
+                {
+                    for (const auto &entry : shard.entries)
+                    {
+                        bytes += GetHeapBytes(entry.second);
+                    }
+                }
+            }
+            return bytes;
+        }
+
+        Stats GetStats() const
+        {
+            Stats stats{hits_.load(std::memory_order_relaxed), misses_.load(std::memory_order_relaxed), 0};
+            for (const auto &shard : shards_)
+            {
+                std::lock_guard lock(shard.mutex);
+                stats.size += shard.entries.size();
+            }
+            return stats;
+        }
+
+    private:
+        struct alignas(64) Shard
+        {
+            mutable std::mutex mutex;
+            // Записи от недавно использованных к давно не использованным
+            std::list<std::pair<Key, Value>> entries;
+            std::unordered_map<Key, typename std::list<std::pair<Key, Value>>::iterator, Hash> index;
+        };
+
+        Shard &GetShard(const Key &key)
+        {
+            // Старшие биты подмешиваются, чтобы часть не выбиралась по тем же битам, что и корзина внутри неё
+            const size_t hash = Hash{}(key);
+            return shards_[(hash ^ (hash >> 32)) % SHARD_COUNT];
+        }
+
+        const size_t shard_capacity_;
+        std::array<Shard, SHARD_COUNT> shards_;
+        std::atomic<uint64_t> hits_ = 0;
+        std::atomic<uint64_t> misses_ = 0;
+    };
+}
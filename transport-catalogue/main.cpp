@@ -1,10 +1,24 @@
+#include <algorithm>
+#include <csignal>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <optional>
+#include <sstream>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <vector>
 
+#include "cbor.h"
 #include "json_reader.h"
 #include "map_renderer.h"
+#include "metrics.h"
 #include "request_handler.h"
+#include "request_pipeline.h"
+#include "server.h"
+#include "versioned_catalogue.h"
 
 using namespace std;
 using namespace catalogue;
@@ -12,20 +26,236 @@ using namespace catalogue::json;
 using namespace catalogue::renderer;
 using namespace catalogue::router;
 
-int main()
+enum class OutputFormat
 {
+    JSON,
+    CBOR,
+};
+
+struct Options
+{
+    // Число потоков для подготовки карты, 0 — карта строится в основном потоке
+    size_t render_threads = 0;
+    OutputFormat format = OutputFormat::JSON;
+    // Если задан, вместо ответа на stat_requests запускается сервер на этом Unix-сокете
+    std::string serve_path;
+    // Число потоков сервера и конвейера запросов, 0 — по числу ядер
+    size_t workers = 0;
+    // Если больше 0, ответы выводятся по мере чтения stat_requests, и в работе не больше стольких запросов
+    size_t pipeline_depth = 0;
+    // Если задан, при завершении сюда записываются метрики в текстовом формате Prometheus
+    std::string metrics_path;
+};
+
+Server *running_server = nullptr;
+
+void StopServer(int)
+{
+    if (running_server)
+    {
+        running_server->Stop();
+    }
+}
+
+Options ParseOptions(int argc, char *argv[])
+{
+    using namespace std::literals;
+
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg = argv[i];
+        if (arg == "--render-threads"sv && i + 1 < argc)
+        {
+            options.render_threads = std::stoul(argv[++i]);
+        }
+        else if (arg == "--serve"sv && i + 1 < argc)
+        {
+            options.serve_path = argv[++i];
+        }
+        else if (arg == "--workers"sv && i + 1 < argc)
+        {
+            options.workers = std::stoul(argv[++i]);
+        }
+        else if (arg == "--pipeline"sv && i + 1 < argc)
+        {
+            options.pipeline_depth = std::stoul(argv[++i]);
+        }
+        else if (arg == "--metrics-file"sv && i + 1 < argc)
+        {
+            options.metrics_path = argv[++i];
+        }
+        else if (arg == "--format"sv && i + 1 < argc)
+        {
+            const std::string_view format = argv[++i];
+            if (format == "cbor"sv)
+            {
+                options.format = OutputFormat::CBOR;
+            }
+            else if (format != "json"sv)
+            {
+                std::cerr << "Unknown output format: "sv << format << std::endl;
+            }
+        }
+        else
+        {
+            std::cerr << "Unknown option: "sv << arg << std::endl;
+        }
+    }
+    return options;
+}
+
+void WriteMetrics(const Options &options, const RequestHandler &request_handler)
+{
+    if (options.metrics_path.empty())
+    {
+        return;
+    }
+    std::ofstream out(options.metrics_path);
+    if (!out)
+    {
+        std::cerr << "Can't open metrics file "s << options.metrics_path << std::endl;
+        return;
+    }
+    metrics::PrintPrometheus(request_handler.GetStats(), out);
+}
+
+// Пишет одной строкой, сколько памяти занимает каждая структура после загрузки
+void LogMemoryUsage(MemoryUsage usage, size_t document_bytes)
+{
+    usage.Add("json.document", document_bytes);
+    const auto to_kibibytes = [](size_t bytes)
+    {
+        return bytes / 1024.0;
+    };
+
+    std::ostringstream line;
+    line << std::fixed << std::setprecision(1) << "Memory, KiB: total "sv << to_kibibytes(usage.GetTotal());
+    for (const auto &[name, bytes] : usage.items)
+    {
+        line << ", "sv << name << ' ' << to_kibibytes(bytes);
+    }
+    std::cerr << line.str() << std::endl;
+}
+
+size_t GetWorkerCount(const Options &options)
+{
+    return options.workers > 0 ? options.workers : std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Отвечает на stat_requests по мере их чтения. Справочник строится, как только прочитаны
+// остальные разделы; если stat_requests идут раньше них, запросы сначала читаются целиком
+void RunPipeline(const Options &options, ThreadPool *render_pool)
+{
+    TransportCatalogue catalogue;
+    RenderSettings rend_sett;
+    RouterSettings rout_sett;
+    std::vector<StatRequests> stat_requests;
+    Dict sections;
+
+    std::optional<MapRenderer> map_rend;
+    std::optional<TransportRouter> router;
+    std::optional<RequestHandler> request_handler;
+    std::optional<RequestPipeline> pipeline;
+
+    const auto start = [&]
+    {
+        // При чтении по мере поступления запросы в ParseMap не попадают
+        sections.emplace("stat_requests", Array{});
+        ParseMap(sections, catalogue, stat_requests, rend_sett, rout_sett);
+        map_rend.emplace(rend_sett);
+        router.emplace(rout_sett, catalogue);
+        request_handler.emplace(catalogue, *map_rend, *router, render_pool);
+        LogMemoryUsage(request_handler->GetMemoryUsage(), GetMemoryUsage(sections));
+        pipeline.emplace(*request_handler, std::cout, GetWorkerCount(options), options.pipeline_depth);
+    };
+
+    LoadDictIncrementally(
+        std::cin,
+        [&](const std::string &key) -> ElementHandler
+        {
+            const bool is_ready = sections.count("base_requests") > 0 && sections.count("render_settings") > 0 && sections.count("routing_settings") > 0;
+            if (key != "stat_requests" || !is_ready)
+            {
+                return {};
+            }
+            start();
+            return [&pipeline](Node request)
+            {
+                pipeline->Push(ParseCommandDescription(request));
+            };
+        },
+        [&sections](std::string key, Node value)
+        {
+            sections.emplace(std::move(key), std::move(value));
+        });
+
+    if (!pipeline)
+    {
+        start();
+        for (auto &request : stat_requests)
+        {
+            pipeline->Push(std::move(request));
+        }
+    }
+    pipeline->Finish();
+    WriteMetrics(options, *request_handler);
+}
+
+int main(int argc, char *argv[])
+{
+    const Options options = ParseOptions(argc, argv);
+
+    std::unique_ptr<ThreadPool> render_pool;
+    if (options.render_threads > 0)
+    {
+        render_pool = std::make_unique<ThreadPool>(options.render_threads);
+    }
+
+    if (options.pipeline_depth > 0 && options.serve_path.empty() && options.format == OutputFormat::JSON)
+    {
+        RunPipeline(options, render_pool.get());
+        return 0;
+    }
+
     Document doc;
     TransportCatalogue catalogue;
     RenderSettings rend_sett;
     RouterSettings rout_sett;
     std::vector<StatRequests> stat_requests;
 
-    doc = Load(std::cin);
+    {
+        metrics::ScopedTimer timer(metrics::RecordPhase, "load");
+        doc = Load(std::cin);
+    }
     ParseRequests(doc, catalogue, stat_requests, rend_sett, rout_sett);
 
+    if (!options.serve_path.empty())
+    {
+        VersionedCatalogue versions(std::move(catalogue), rend_sett, rout_sett, render_pool.get());
+        LogMemoryUsage(versions.Read().GetHandler().GetMemoryUsage(), GetMemoryUsage(doc));
+        Server server(versions, GetWorkerCount(options));
+        running_server = &server;
+        std::signal(SIGINT, StopServer);
+        std::signal(SIGTERM, StopServer);
+        const bool is_ok = server.Run(options.serve_path);
+        running_server = nullptr;
+        WriteMetrics(options, versions.Read().GetHandler());
+        return is_ok ? 0 : 1;
+    }
+
     MapRenderer map_rend(rend_sett);
     TransportRouter router(rout_sett, catalogue);
-    RequestHandler request_handler(catalogue, map_rend, router);
-    Document output = GetOutputDocument(request_handler, stat_requests);
-    Print(output, std::cout);
+    RequestHandler request_handler(catalogue, map_rend, router, render_pool.get());
+    LogMemoryUsage(request_handler.GetMemoryUsage(), GetMemoryUsage(doc));
+
+    if (options.format == OutputFormat::CBOR)
+    {
+        PrintCbor(GetOutputDocument(request_handler, stat_requests), std::cout);
+    }
+    else
+    {
+        PrintOutput(request_handler, stat_requests, std::cout);
+    }
+    WriteMetrics(options, request_handler);
 }
\ No newline at end of file
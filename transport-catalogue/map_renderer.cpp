@@ -1,5 +1,9 @@
 #include "map_renderer.h"
 
+#include <cmath>
+#include <sstream>
+#include <unordered_set>
+
 namespace catalogue
 {
     namespace renderer
@@ -11,197 +15,450 @@ namespace catalogue
                 (max_lat_ - coords.lat) * zoom_coeff_ + padding_};
         }
 
-        MapRenderer::MapRenderer(RenderSettings &render_settings)
-            : render_settings_(render_settings) {}
+        double SphereProjector::GetZoom() const
+        {
+            return zoom_coeff_;
+        }
 
-        void MapRenderer::SetRouteProperties(svg::Polyline &route, int index) const
+        namespace
         {
-            const auto &color_pal = render_settings_.color_palette;
-            if (color_pal.size() > 0)
+            // Квадрат расстояния от точки до отрезка на плоскости (lng, lat)
+            double SquaredDistanceToSegment(geo::Coordinates point, geo::Coordinates from, geo::Coordinates to)
             {
-                route.SetFillColor("none");
-                route.SetStrokeColor(color_pal[index % color_pal.size()]);
-                route.SetStrokeLineCap(svg::StrokeLineCap::ROUND);
-                route.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
-                route.SetStrokeWidth(render_settings_.line_width);
+                const double d_lng = to.lng - from.lng;
+                const double d_lat = to.lat - from.lat;
+                const double length = d_lng * d_lng + d_lat * d_lat;
+                double t = 0.0;
+                if (length > 0.0)
+                {
+                    t = std::clamp(((point.lng - from.lng) * d_lng + (point.lat - from.lat) * d_lat) / length, 0.0, 1.0);
+                }
+                const double lng = from.lng + t * d_lng - point.lng;
+                const double lat = from.lat + t * d_lat - point.lat;
+                return lng * lng + lat * lat;
             }
-        }
 
-        void MapRenderer::SetRouteNameProperties(svg::Text &route_label, svg::Text &route_text, const svg::Point &screen_coord, std::string_view bus_name, int index) const
-        {
-            const auto &color_pal = render_settings_.color_palette;
-            if (color_pal.size() > 0)
+            // Упрощает ломаную алгоритмом Дугласа-Пекера, сохраняя первую и последнюю вершины
+            std::vector<geo::Coordinates> SimplifyPolyline(const std::vector<const Stop *> &stops, double tolerance)
             {
-                route_label.SetFillColor(render_settings_.underlayer_color);
-                route_text.SetFillColor(color_pal[index % color_pal.size()]);
+                if (stops.size() < 3)
+                {
+                    std::vector<geo::Coordinates> result;
+                    for (const Stop *stop : stops)
+                    {
+                        result.push_back(stop->coords);
+                    }
+                    return result;
+                }
 
-                route_label.SetStrokeColor(render_settings_.underlayer_color);
-                route_label.SetStrokeWidth(render_settings_.underlayer_width);
-                route_label.SetStrokeLineCap(svg::StrokeLineCap::ROUND);
-                route_label.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
+                std::vector<bool> is_kept(stops.size(), false);
+                is_kept.front() = true;
+                is_kept.back() = true;
 
-                route_label.SetPosition(screen_coord);
-                route_text.SetPosition(screen_coord);
+                const double squared_tolerance = tolerance * tolerance;
+                std::vector<std::pair<size_t, size_t>> ranges = {{0, stops.size() - 1}};
+                while (!ranges.empty())
+                {
+                    const auto [first, last] = ranges.back();
+                    ranges.pop_back();
+
+                    double max_distance = 0.0;
+                    size_t farthest = first;
+                    for (size_t i = first + 1; i < last; ++i)
+                    {
+                        const double distance = SquaredDistanceToSegment(stops[i]->coords, stops[first]->coords, stops[last]->coords);
+                        if (distance > max_distance)
+                        {
+                            max_distance = distance;
+                            farthest = i;
+                        }
+                    }
+
+                    if (max_distance > squared_tolerance)
+                    {
+                        is_kept[farthest] = true;
+                        ranges.push_back({first, farthest});
+                        ranges.push_back({farthest, last});
+                    }
+                }
 
-                const svg::Point offset{render_settings_.bus_label_offset.first, render_settings_.bus_label_offset.second};
-                route_label.SetOffset(offset);
-                route_text.SetOffset(offset);
+                std::vector<geo::Coordinates> result;
+                for (size_t i = 0; i < stops.size(); ++i)
+                {
+                    if (is_kept[i])
+                    {
+                        result.push_back(stops[i]->coords);
+                    }
+                }
+                return result;
+            }
+        } // namespace
 
-                route_label.SetFontSize(render_settings_.bus_label_font_size);
-                route_text.SetFontSize(render_settings_.bus_label_font_size);
+        MapRenderer::SimplifiedRoutes::SimplifiedRoutes(double tolerance)
+            : tolerance_(tolerance) {}
 
-                route_label.SetFontFamily("Verdana");
-                route_text.SetFontFamily("Verdana");
+        const std::vector<geo::Coordinates> &MapRenderer::SimplifiedRoutes::Get(const Bus &bus)
+        {
+            std::lock_guard lock(mutex_);
+            auto it = routes_.find(&bus);
+            if (it == routes_.end())
+            {
+                it = routes_.emplace(&bus, SimplifyPolyline(bus.bus_stops, tolerance_)).first;
+            }
+            return it->second;
+        }
 
-                route_label.SetFontWeight("bold");
-                route_text.SetFontWeight("bold");
+        MapRenderer::MapRenderer(RenderSettings &render_settings)
+            : render_settings_(render_settings) {}
 
-                route_label.SetData(std::string(bus_name));
-                route_text.SetData(std::string(bus_name));
+        void MapRenderer::RenderMap(svg::StreamWriter &writer, const std::vector<geo::Coordinates> &stop_coords, const std::vector<std::string_view> &buses, const BusNameIndex &busname_to_bus, const std::map<std::string_view, geo::Coordinates> &stops) const
+        {
+            if (buses.empty())
+            {
+                writer.Begin();
+                writer.End();
+                return;
             }
+
+            const auto proj = GetSphereProjector(stop_coords);
+            const MapStyles styles = MakeMapStyles(proj);
+            DefineClasses(writer, styles);
+            writer.Begin();
+            const auto thinned_stops = ThinOutStops(proj, stops);
+            const auto &visible_stops = thinned_stops ? *thinned_stops : stops;
+            RenderBusRoutes(writer, proj, styles, buses.begin(), buses.end(), 0, busname_to_bus);
+            RenderRoutesName(writer, proj, styles, buses.begin(), buses.end(), 0, busname_to_bus);
+            RenderStopCircle(writer, proj, styles, visible_stops.begin(), visible_stops.end());
+            RenderStopName(writer, proj, styles, visible_stops.begin(), visible_stops.end());
+            writer.End();
         }
 
-        void MapRenderer::SetStopIconProperties(svg::Circle &stop_icon) const
+        void MapRenderer::RenderMap(svg::StreamWriter &writer, ThreadPool &pool, const std::vector<geo::Coordinates> &stop_coords, const std::vector<std::string_view> &buses, const BusNameIndex &busname_to_bus, const std::map<std::string_view, geo::Coordinates> &stops) const
         {
-            stop_icon.SetRadius(render_settings_.stop_radius);
-            stop_icon.SetFillColor("white");
+            if (buses.empty())
+            {
+                writer.Begin();
+                writer.End();
+                return;
+            }
+
+            const auto proj = GetSphereProjector(stop_coords);
+            const MapStyles styles = MakeMapStyles(proj);
+            DefineClasses(writer, styles);
+            writer.Begin();
+            const auto thinned_stops = ThinOutStops(proj, stops);
+            const auto &visible_stops = thinned_stops ? *thinned_stops : stops;
+
+            // На каждый поток приходится несколько частей слоя, чтобы сгладить разницу в длине маршрутов
+            const size_t parts_per_layer = pool.GetThreadCount() * 4;
+            const size_t bus_chunk = std::max<size_t>(1, buses.size() / parts_per_layer);
+            const size_t stop_chunk = std::max<size_t>(1, visible_stops.size() / parts_per_layer);
+
+            // Границы частей и номер цвета первого маршрута каждой части
+            std::vector<std::pair<BusIt, int>> bus_parts;
+            int color_index = 0;
+            for (auto it = buses.begin(); it != buses.end(); ++it)
+            {
+                if (static_cast<size_t>(it - buses.begin()) % bus_chunk == 0)
+                {
+                    bus_parts.push_back({it, color_index});
+                }
+                if (!busname_to_bus.at(*it)->bus_stops.empty())
+                {
+                    ++color_index;
+                }
+            }
+            bus_parts.push_back({buses.end(), color_index});
+
+            std::vector<StopIt> stop_parts;
+            size_t stop_index = 0;
+            for (auto it = visible_stops.begin(); it != visible_stops.end(); ++it, ++stop_index)
+            {
+                if (stop_index % stop_chunk == 0)
+                {
+                    stop_parts.push_back(it);
+                }
+            }
+            stop_parts.push_back(visible_stops.end());
+
+            const auto render_part = [&pool, &writer](auto render)
+            {
+                return pool.Submit([render, &writer]
+                                   {
+                                       std::ostringstream out;
+                                       svg::StreamWriter part_writer = writer.MakeFragmentWriter(out);
+                                       render(part_writer);
+                                       return out.str(); });
+            };
+
+            std::vector<std::future<std::string>> parts;
+            for (size_t i = 0; i + 1 < bus_parts.size(); ++i)
+            {
+                const BusIt first = bus_parts[i].first;
+                const BusIt last = bus_parts[i + 1].first;
+                const int index = bus_parts[i].second;
+                parts.push_back(render_part([&, first, last, index](svg::StreamWriter &part_writer)
+                                            { RenderBusRoutes(part_writer, proj, styles, first, last, index, busname_to_bus); }));
+            }
+            for (size_t i = 0; i + 1 < bus_parts.size(); ++i)
+            {
+                const BusIt first = bus_parts[i].first;
+                const BusIt last = bus_parts[i + 1].first;
+                const int index = bus_parts[i].second;
+                parts.push_back(render_part([&, first, last, index](svg::StreamWriter &part_writer)
+                                            { RenderRoutesName(part_writer, proj, styles, first, last, index, busname_to_bus); }));
+            }
+            for (size_t i = 0; i + 1 < stop_parts.size(); ++i)
+            {
+                const StopIt first = stop_parts[i];
+                const StopIt last = stop_parts[i + 1];
+                parts.push_back(render_part([&, first, last](svg::StreamWriter &part_writer)
+                                            { RenderStopCircle(part_writer, proj, styles, first, last); }));
+            }
+            for (size_t i = 0; i + 1 < stop_parts.size(); ++i)
+            {
+                const StopIt first = stop_parts[i];
+                const StopIt last = stop_parts[i + 1];
+                parts.push_back(render_part([&, first, last](svg::StreamWriter &part_writer)
+                                            { RenderStopName(part_writer, proj, styles, first, last); }));
+            }
+
+            // Задачи ссылаются на локальные proj и styles, поэтому дожидаемся всех до выхода из функции
+            for (auto &part : parts)
+            {
+                part.wait();
+            }
+            for (auto &part : parts)
+            {
+                writer.WriteRaw(part.get());
+            }
+            writer.End();
         }
 
-        void MapRenderer::SetStopNameProperties(svg::Text &stop_label, svg::Text &stop_text, std::string_view stop_name) const
+        MapRenderer::MapStyles MapRenderer::MakeMapStyles(const SphereProjector &proj) const
         {
-            const svg::Point offset{render_settings_.stop_label_offset.first, render_settings_.stop_label_offset.second};
-            stop_label.SetOffset(offset);
-            stop_text.SetOffset(offset);
+            MapStyles styles;
+            styles.simplified_routes = GetSimplifiedRoutes(proj);
 
-            stop_label.SetFontSize(render_settings_.stop_label_font_size);
-            stop_text.SetFontSize(render_settings_.stop_label_font_size);
-
-            stop_label.SetFontFamily("Verdana");
-            stop_text.SetFontFamily("Verdana");
+            for (const auto &color : render_settings_.color_palette)
+            {
+                styles.route_styles.push_back({svg::Color{"none"}, color, render_settings_.line_width, svg::StrokeLineCap::ROUND, svg::StrokeLineJoin::ROUND});
+                styles.route_name_styles.push_back({color, std::nullopt, std::nullopt, std::nullopt, std::nullopt});
+            }
 
-            stop_label.SetData(std::string(stop_name));
-            stop_text.SetData(std::string(stop_name));
+            styles.underlayer_style = {render_settings_.underlayer_color, render_settings_.underlayer_color, render_settings_.underlayer_width, svg::StrokeLineCap::ROUND, svg::StrokeLineJoin::ROUND};
+            styles.stop_icon_style.fill_color = svg::Color{"white"};
+            styles.stop_name_style.fill_color = svg::Color{"black"};
 
-            stop_label.SetFillColor(render_settings_.underlayer_color);
-            stop_text.SetFillColor("black");
+            const auto &[bus_dx, bus_dy] = render_settings_.bus_label_offset;
+            styles.route_name_text = {{bus_dx, bus_dy}, static_cast<uint32_t>(render_settings_.bus_label_font_size), "Verdana", "bold"};
+            const auto &[stop_dx, stop_dy] = render_settings_.stop_label_offset;
+            styles.stop_name_text = {{stop_dx, stop_dy}, static_cast<uint32_t>(render_settings_.stop_label_font_size), "Verdana", {}};
+            return styles;
+        }
 
-            stop_label.SetStrokeColor(render_settings_.underlayer_color);
-            stop_label.SetStrokeWidth(render_settings_.underlayer_width);
-            stop_label.SetStrokeLineCap(svg::StrokeLineCap::ROUND);
-            stop_label.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
+        void MapRenderer::DefineClasses(svg::StreamWriter &writer, const MapStyles &styles) const
+        {
+            for (const auto &style : styles.route_styles)
+            {
+                writer.DefineClass(style);
+            }
+            for (const auto &style : styles.route_name_styles)
+            {
+                writer.DefineLabelClass(styles.underlayer_style, style, styles.route_name_text);
+            }
+            writer.DefineClass(styles.stop_icon_style);
+            writer.DefineLabelClass(styles.underlayer_style, styles.stop_name_style, styles.stop_name_text);
         }
 
-        void MapRenderer::RenderBusRoutes(svg::Document &doc, const SphereProjector &proj, const std::vector<std::string_view> &buses, const std::unordered_map<std::string_view, const Bus *> &busname_to_bus) const
+        svg::StreamWriter MapRenderer::MakeWriter(std::ostream &out) const
         {
-            std::vector<geo::Coordinates> stops_coordinates;
-            int index = 0;
-            for (const auto &bus : buses)
+            if (render_settings_.compact_precision)
             {
+                return svg::StreamWriter(out, svg::CompactFormat{*render_settings_.compact_precision});
+            }
+            return svg::StreamWriter(out);
+        }
 
-                for (const auto &stop : busname_to_bus.at(bus)->bus_stops)
+        void MapRenderer::RenderBusRoute(svg::StreamWriter &writer, const SphereProjector &proj, const MapStyles &styles, const Bus &bus, int index) const
+        {
+            static const svg::PathStyle empty_style;
+            const auto &route_styles = styles.route_styles;
+            writer.BeginPolyline();
+            if (styles.simplified_routes)
+            {
+                for (const auto &coords : styles.simplified_routes->Get(bus))
                 {
-                    double lat = stop->coords.lat;
-                    double lng = stop->coords.lng;
-                    stops_coordinates.push_back({lat, lng});
+                    writer.AddPolylinePoint(proj(coords));
                 }
-
-                if (stops_coordinates.empty())
+            }
+            else
+            {
+                for (const auto &stop : bus.bus_stops)
                 {
-                    continue;
+                    writer.AddPolylinePoint(proj(stop->coords));
                 }
+            }
+            writer.EndPolyline(route_styles.empty() ? empty_style : route_styles[index % route_styles.size()]);
+        }
 
-                svg::Polyline route;
-                for (const auto &coord : stops_coordinates)
+        void MapRenderer::RenderBusRoutes(svg::StreamWriter &writer, const SphereProjector &proj, const MapStyles &styles, BusIt first, BusIt last, int index, const BusNameIndex &busname_to_bus) const
+        {
+            for (; first != last; ++first)
+            {
+                const Bus &bus = *busname_to_bus.at(*first);
+                if (bus.bus_stops.empty())
                 {
-                    const svg::Point screen_coord = proj(coord);
-                    route.AddPoint(screen_coord);
+                    continue;
                 }
 
-                SetRouteProperties(route, index);
+                RenderBusRoute(writer, proj, styles, bus, index);
                 ++index;
+            }
+        }
 
-                doc.Add(route);
-                stops_coordinates.clear();
+        void MapRenderer::RenderRouteName(svg::StreamWriter &writer, const MapStyles &styles, const svg::Point &screen_coord, std::string_view bus_name, int index) const
+        {
+            const auto &name_styles = styles.route_name_styles;
+            if (name_styles.empty())
+            {
+                // Без палитры надписи выводятся пустыми, без атрибутов
+                static const svg::PathStyle empty_style;
+                writer.WriteText({}, {}, empty_style, {});
+                writer.WriteText({}, {}, empty_style, {});
+                return;
             }
+
+            writer.WriteLabel(screen_coord, styles.route_name_text, styles.underlayer_style, name_styles[index % name_styles.size()], bus_name);
         }
 
-        void MapRenderer::RenderRoutesName(svg::Document &doc, const SphereProjector &proj, const std::vector<std::string_view> &buses, const std::unordered_map<std::string_view, const Bus *> &busname_to_bus) const
+        void MapRenderer::RenderRoutesName(svg::StreamWriter &writer, const SphereProjector &proj, const MapStyles &styles, BusIt first, BusIt last, int index, const BusNameIndex &busname_to_bus) const
         {
-            int index = 0;
-            for (const auto &bus : buses)
+            for (; first != last; ++first)
             {
+                const std::string_view bus = *first;
                 const auto &bus_info = busname_to_bus.at(bus);
-                const bool is_roundtrip = bus_info->is_roundtrip;
                 const auto &bus_stops = bus_info->bus_stops;
                 if (bus_stops.empty())
                 {
                     continue;
                 }
 
-                svg::Text route_label;
-                svg::Text route_text;
+                RenderRouteName(writer, styles, proj(bus_stops[0]->coords), bus, index);
 
-                const svg::Point screen_coord = proj(bus_stops[0]->coords);
-                SetRouteNameProperties(route_label, route_text, screen_coord, bus, index);
-
-                doc.Add(route_label);
-                doc.Add(route_text);
-
-                if (!is_roundtrip && bus_stops[0] != bus_stops[bus_stops.size() / 2])
+                if (!bus_info->is_roundtrip && bus_stops[0] != bus_stops[bus_stops.size() / 2])
                 {
-                    svg::Text second_route_label;
-                    svg::Text second_route_text;
-
-                    const svg::Point sec_screen_coord = proj(bus_stops[bus_stops.size() / 2]->coords);
-                    SetRouteNameProperties(second_route_label, second_route_text, sec_screen_coord, bus, index);
-
-                    doc.Add(second_route_label);
-                    doc.Add(second_route_text);
+                    RenderRouteName(writer, styles, proj(bus_stops[bus_stops.size() / 2]->coords), bus, index);
                 }
                 ++index;
             }
         }
 
-        void MapRenderer::RenderStopCircle(svg::Document &doc, const SphereProjector &proj, const std::map<std::string_view, geo::Coordinates> &stops) const
+        void MapRenderer::RenderStopCircle(svg::StreamWriter &writer, const SphereProjector &proj, const MapStyles &styles, StopIt first, StopIt last) const
         {
-
-            for (const auto &[stop_name, coord] : stops)
+            for (; first != last; ++first)
             {
-                svg::Circle stop_icon;
-                stop_icon.SetCenter(proj(coord));
-                SetStopIconProperties(stop_icon);
+                writer.WriteCircle(proj(first->second), render_settings_.stop_radius, styles.stop_icon_style);
+            }
+        }
 
-                doc.Add(stop_icon);
+        void MapRenderer::RenderStopName(svg::StreamWriter &writer, const SphereProjector &proj, const MapStyles &styles, StopIt first, StopIt last) const
+        {
+            for (; first != last; ++first)
+            {
+                const auto &[stop_name, coord] = *first;
+                const svg::Point screen_coord = proj(coord);
+                writer.WriteLabel(screen_coord, styles.stop_name_text, styles.underlayer_style, styles.stop_name_style, stop_name);
             }
         }
 
-        void MapRenderer::RenderStopName(svg::Document &doc, const SphereProjector &proj, const std::map<std::string_view, geo::Coordinates> &stops) const
+        void MapRenderer::RenderMap(svg::StreamWriter &writer, const geo::BoundingBox &viewport, const SpatialIndex &index) const
         {
-            for (const auto &[stop_name, coord] : stops)
+            const std::vector<geo::Coordinates> corners = {viewport.min, viewport.max};
+            const auto proj = GetSphereProjector(corners);
+            const MapStyles styles = MakeMapStyles(proj);
+            DefineClasses(writer, styles);
+            writer.Begin();
+
+            const auto visible = index.Query(viewport);
+
+            for (const auto &[bus, color_index] : visible.buses)
             {
-                svg::Text stop_label;
-                svg::Text stop_text;
+                RenderBusRoute(writer, proj, styles, *bus, color_index);
+            }
 
-                const svg::Point screen_coord = proj(coord);
-                stop_label.SetPosition(screen_coord);
-                stop_text.SetPosition(screen_coord);
+            // Подпись маршрута выводится, только если её остановка видна
+            for (const auto &[bus, color_index] : visible.buses)
+            {
+                const auto &bus_stops = bus->bus_stops;
+                if (viewport.Contains(bus_stops[0]->coords))
+                {
+                    RenderRouteName(writer, styles, proj(bus_stops[0]->coords), bus->bus_name, color_index);
+                }
+
+                const Stop *second_end = bus_stops[bus_stops.size() / 2];
+                if (!bus->is_roundtrip && bus_stops[0] != second_end && viewport.Contains(second_end->coords))
+                {
+                    RenderRouteName(writer, styles, proj(second_end->coords), bus->bus_name, color_index);
+                }
+            }
+
+            std::map<std::string_view, geo::Coordinates> stops;
+            for (const Stop *stop : visible.stops)
+            {
+                stops.emplace(stop->stop_name, stop->coords);
+            }
+            if (auto thinned_stops = ThinOutStops(proj, stops))
+            {
+                stops = std::move(*thinned_stops);
+            }
+            RenderStopCircle(writer, proj, styles, stops.begin(), stops.end());
+            RenderStopName(writer, proj, styles, stops.begin(), stops.end());
+            writer.End();
+        }
+
+        MapRenderer::SimplifiedRoutes *MapRenderer::GetSimplifiedRoutes(const SphereProjector &proj) const
+        {
+            const double zoom = proj.GetZoom();
+            if (render_settings_.lod_tolerance <= 0.0 || zoom <= 0.0)
+            {
+                return nullptr;
+            }
 
-                SetStopNameProperties(stop_label, stop_text, stop_name);
+            // Уровни масштаба идут с шагом в корень из двух. Масштаб уровня не меньше фактического,
+            // поэтому отклонение на экране не превышает заданного допуска
+            const int level = static_cast<int>(std::ceil(2.0 * std::log2(zoom)));
+            const double level_zoom = std::exp2(level / 2.0);
 
-                doc.Add(stop_label);
-                doc.Add(stop_text);
+            std::lock_guard lock(lod_mutex_);
+            auto &routes = lod_cache_[level];
+            if (!routes)
+            {
+                routes = std::make_unique<SimplifiedRoutes>(render_settings_.lod_tolerance / level_zoom);
             }
+            return routes.get();
         }
 
-        svg::Document MapRenderer::RenderMap(const std::vector<geo::Coordinates> &stop_coords, const std::vector<std::string_view> &buses, const std::unordered_map<std::string_view, const Bus *> &busname_to_bus, const std::map<std::string_view, geo::Coordinates> &stops) const
+        std::optional<std::map<std::string_view, geo::Coordinates>> MapRenderer::ThinOutStops(const SphereProjector &proj, const std::map<std::string_view, geo::Coordinates> &stops) const
         {
-            svg::Document result;
-            const auto &proj = GetSphereProjector(stop_coords);
-            RenderBusRoutes(result, proj, buses, busname_to_bus);
-            RenderRoutesName(result, proj, buses, busname_to_bus);
-            RenderStopCircle(result, proj, stops);
-            RenderStopName(result, proj, stops);
+            const double cell_size = render_settings_.lod_cell_size;
+            if (cell_size <= 0.0)
+            {
+                return std::nullopt;
+            }
 
+            std::map<std::string_view, geo::Coordinates> result;
+            std::unordered_set<uint64_t> occupied_cells;
+            for (const auto &[stop_name, coord] : stops)
+            {
+                const svg::Point point = proj(coord);
+                const auto column = static_cast<uint32_t>(static_cast<int32_t>(std::floor(point.x / cell_size)));
+                const auto row = static_cast<uint32_t>(static_cast<int32_t>(std::floor(point.y / cell_size)));
+                if (occupied_cells.insert((uint64_t{row} << 32) | column).second)
+                {
+                    result.emplace_hint(result.end(), stop_name, coord);
+                }
+            }
             return result;
         }
 
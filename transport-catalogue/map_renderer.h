@@ -2,10 +2,14 @@
 
 #include "domain.h"
 #include "geo.h"
+#include "spatial_index.h"
 #include "svg.h"
+#include "thread_pool.h"
 
 #include <algorithm>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <unordered_map>
 
 namespace catalogue
@@ -25,6 +29,9 @@ namespace catalogue
             // Проецирует широту и долготу в координаты внутри SVG-изображения
             svg::Point operator()(geo::Coordinates coords) const;
 
+            // Число пикселей на градус широты или долготы
+            double GetZoom() const;
+
         private:
             bool IsZero(double value)
             {
@@ -57,6 +64,14 @@ namespace catalogue
             double underlayer_width;
 
             std::vector<svg::Color> color_palette;
+
+            // Режим упрощения карты: допустимое отклонение ломаных маршрутов в пикселях, 0 — режим выключен
+            double lod_tolerance = 0.0;
+            // Из остановок, попавших в одну ячейку экрана такого размера, выводится только первая по названию
+            double lod_cell_size = 0.0;
+
+            // Если задано, карта выводится в компактном виде с этим числом знаков после запятой
+            std::optional<int> compact_precision;
         };
 
         class MapRenderer
@@ -64,28 +79,85 @@ namespace catalogue
         public:
             MapRenderer(RenderSettings &render_settings);
 
-            void SetRouteProperties(svg::Polyline &route, int index) const;
+            // Выводит карту сразу в поток
+            void RenderMap(svg::StreamWriter &writer, const std::vector<geo::Coordinates> &stop_coords, const std::vector<std::string_view> &buses, const BusNameIndex &busname_to_bus, const std::map<std::string_view, geo::Coordinates> &stops) const;
 
-            void SetRouteNameProperties(svg::Text &route_label, svg::Text &route_text, const svg::Point &screen_coord, std::string_view bus_name, int index) const;
+            // Готовит фрагменты слоёв карты параллельно в пуле потоков и выводит их в прежнем порядке.
+            // Результат совпадает с последовательным RenderMap. Пул не должен быть тем же,
+            // в котором выполняется сам вызов, иначе потоки будут ждать друг друга
+            void RenderMap(svg::StreamWriter &writer, ThreadPool &pool, const std::vector<geo::Coordinates> &stop_coords, const std::vector<std::string_view> &buses, const BusNameIndex &busname_to_bus, const std::map<std::string_view, geo::Coordinates> &stops) const;
 
-            void SetStopIconProperties(svg::Circle &stop_icon) const;
+            // Выводит только маршруты и остановки, попадающие в область viewport, вписывая её в размер карты
+            void RenderMap(svg::StreamWriter &writer, const geo::BoundingBox &viewport, const SpatialIndex &index) const;
+
+            SphereProjector GetSphereProjector(const std::vector<geo::Coordinates> &stops_coordinates) const;
 
-            void SetStopNameProperties(svg::Text &stop_label, svg::Text &stop_text, std::string_view stop_name) const;
+            // Создаёт writer с форматом вывода из настроек отрисовки
+            svg::StreamWriter MakeWriter(std::ostream &out) const;
 
-            void RenderBusRoutes(svg::Document &doc, const SphereProjector &proj, const std::vector<std::string_view> &buses, const std::unordered_map<std::string_view, const Bus *> &busname_to_bus) const;
+        private:
+            using BusIt = std::vector<std::string_view>::const_iterator;
+            using StopIt = std::map<std::string_view, geo::Coordinates>::const_iterator;
 
-            void RenderRoutesName(svg::Document &doc, const SphereProjector &proj, const std::vector<std::string_view> &buses, const std::unordered_map<std::string_view, const Bus *> &busname_to_bus) const;
+            // Упрощённые ломаные маршрутов для одного уровня масштаба.
+            // Заполняется по мере обращения к маршрутам и переиспользуется последующими картами
+            class SimplifiedRoutes
+            {
+            public:
+                explicit SimplifiedRoutes(double tolerance);
 
-            void RenderStopCircle(svg::Document &doc, const SphereProjector &proj, const std::map<std::string_view, geo::Coordinates> &stops) const;
+                const std::vector<geo::Coordinates> &Get(const Bus &bus);
 
-            void RenderStopName(svg::Document &doc, const SphereProjector &proj, const std::map<std::string_view, geo::Coordinates> &stops) const;
+            private:
+                std::mutex mutex_;
+                // Допустимое отклонение в градусах
+                double tolerance_;
+                std::unordered_map<const Bus *, std::vector<geo::Coordinates>> routes_;
+            };
 
-            svg::Document RenderMap(const std::vector<geo::Coordinates> &stop_coords, const std::vector<std::string_view> &buses, const std::unordered_map<std::string_view, const Bus *> &busname_to_bus, const std::map<std::string_view, geo::Coordinates> &stops) const;
+            // Наборы атрибутов и данные, которые вычисляются один раз на всю карту
+            struct MapStyles
+            {
+                std::vector<svg::PathStyle> route_styles;
+                std::vector<svg::PathStyle> route_name_styles;
+                svg::PathStyle underlayer_style;
+                svg::PathStyle stop_icon_style;
+                svg::PathStyle stop_name_style;
+                svg::TextStyle route_name_text;
+                svg::TextStyle stop_name_text;
+                // Задано, только если включено упрощение карты
+                SimplifiedRoutes *simplified_routes = nullptr;
+            };
 
-            SphereProjector GetSphereProjector(const std::vector<geo::Coordinates> &stops_coordinates) const;
+            MapStyles MakeMapStyles(const SphereProjector &proj) const;
+
+            // Регистрирует наборы атрибутов карты как классы компактного вывода
+            void DefineClasses(svg::StreamWriter &writer, const MapStyles &styles) const;
+
+            // Возвращает кэш упрощённых маршрутов для масштаба проекции или nullptr, если упрощение выключено
+            SimplifiedRoutes *GetSimplifiedRoutes(const SphereProjector &proj) const;
+
+            // Оставляет по одной остановке на ячейку экрана, сохраняя порядок названий.
+            // Если прореживание выключено, возвращает nullopt
+            std::optional<std::map<std::string_view, geo::Coordinates>> ThinOutStops(const SphereProjector &proj, const std::map<std::string_view, geo::Coordinates> &stops) const;
+
+            void RenderBusRoute(svg::StreamWriter &writer, const SphereProjector &proj, const MapStyles &styles, const Bus &bus, int index) const;
+
+            // index — номер цвета первого маршрута диапазона в палитре
+            void RenderBusRoutes(svg::StreamWriter &writer, const SphereProjector &proj, const MapStyles &styles, BusIt first, BusIt last, int index, const BusNameIndex &busname_to_bus) const;
+
+            void RenderRouteName(svg::StreamWriter &writer, const MapStyles &styles, const svg::Point &screen_coord, std::string_view bus_name, int index) const;
+
+            void RenderRoutesName(svg::StreamWriter &writer, const SphereProjector &proj, const MapStyles &styles, BusIt first, BusIt last, int index, const BusNameIndex &busname_to_bus) const;
+
+            void RenderStopCircle(svg::StreamWriter &writer, const SphereProjector &proj, const MapStyles &styles, StopIt first, StopIt last) const;
+
+            void RenderStopName(svg::StreamWriter &writer, const SphereProjector &proj, const MapStyles &styles, StopIt first, StopIt last) const;
 
-        private:
             RenderSettings &render_settings_;
+
+            mutable std::mutex lod_mutex_;
+            mutable std::map<int, std::unique_ptr<SimplifiedRoutes>> lod_cache_;
         };
 
         template <typename PointInputIt>
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace catalogue
+{
+    /*
+     * Оценка памяти, занятой структурами данных. Считается по ёмкости контейнеров и размерам узлов
+     * без служебных данных распределителя, поэтому ОС обычно видит немного больше
+     */
+    struct MemoryUsage
+    {
+        // Название структуры, например "catalogue.distances", и занятые ею байты
+        std::vector<std::pair<std::string, size_t>> items;
+
+        void Add(std::string name, size_t bytes)
+        {
+            items.emplace_back(std::move(name), bytes);
+        }
+
+        size_t GetTotal() const
+        {
+            size_t total = 0;
+            for (const auto &[name, bytes] : items)
+            {
+                total += bytes;
+            }
+            return total;
+        }
+    };
+
+    // Указатели, которые узлы стандартных контейнеров хранят помимо значения
+    constexpr size_t TREE_NODE_OVERHEAD = 4 * sizeof(void *);
+    constexpr size_t LIST_NODE_OVERHEAD = 2 * sizeof(void *);
+    // Указатель на следующий узел и сохранённый хеш
+    constexpr size_t HASH_NODE_OVERHEAD = 2 * sizeof(void *);
+    // Блок счётчиков ссылок std::make_shared
+    constexpr size_t SHARED_CONTROL_BLOCK = 2 * sizeof(void *);
+
+    // Память в куче, на которую ссылается строка; короткие строки хранятся внутри объекта
+    inline size_t GetHeapBytes(const std::string &value)
+    {
+        const char *data = value.data();
+        const char *object = reinterpret_cast<const char *>(&value);
+        return data >= object && data < object + sizeof(value) ? 0 : value.capacity() + 1;
+    }
+
+    template <typename T>
+    size_t GetHeapBytes(const std::vector<T> &values)
+    {
+        size_t bytes = values.capacity() * sizeof(T);
+        if constexpr (!std::is_trivially_copyable_v<T>)
+        {
+            for (const T &value : values)
+            {
+                bytes += GetHeapBytes(value);
+            }
+        }
+        return bytes;
+    }
+}
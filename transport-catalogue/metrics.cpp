@@ -0,0 +1,210 @@
+#include "metrics.h"
+
+#include <algorithm>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace catalogue
+{
+    namespace metrics
+    {
+        using namespace std::literals;
+
+        namespace
+        {
+            // Видов запросов и этапов немного, поэтому поиск по названию линейный
+            using Histograms = std::vector<std::pair<std::string, LatencyHistogram>>;
+
+            struct ThreadMetrics
+            {
+                std::mutex mutex;
+                Histograms requests;
+                Histograms phases;
+            };
+
+            struct Registry
+            {
+                std::mutex mutex;
+                std::vector<ThreadMetrics *> threads;
+                // Гистограммы завершившихся потоков
+                Snapshot finished;
+            };
+
+            Registry &GetRegistry()
+            {
+                static Registry registry;
+                return registry;
+            }
+
+            void MergeInto(std::map<std::string, LatencyHistogram> &target, const Histograms &source)
+            {
+                for (const auto &[name, histogram] : source)
+                {
+                    target.try_emplace(name, HISTOGRAM_BITS).first->second.Merge(histogram);
+                }
+            }
+
+            // Регистрирует гистограммы потока при первой записи и передаёт их реестру при завершении потока
+            struct ThreadSlot
+            {
+                ThreadMetrics metrics;
+
+                ThreadSlot()
+                {
+                    Registry &registry = GetRegistry();
+                    std::lock_guard lock(registry.mutex);
+                    registry.threads.push_back(&metrics);
+                }
+
+                ~ThreadSlot()
+                {
+                    Registry &registry = GetRegistry();
+                    std::lock_guard lock(registry.mutex);
+                    MergeInto(registry.finished.requests, metrics.requests);
+                    MergeInto(registry.finished.phases, metrics.phases);
+                    registry.threads.erase(std::find(registry.threads.begin(), registry.threads.end(), &metrics));
+                }
+            };
+
+            ThreadMetrics &GetThreadMetrics()
+            {
+                thread_local ThreadSlot slot;
+                return slot.metrics;
+            }
+
+            void Record(Histograms ThreadMetrics::*histograms, std::string_view name, uint64_t nanoseconds)
+            {
+                ThreadMetrics &thread_metrics = GetThreadMetrics();
+                std::lock_guard lock(thread_metrics.mutex);
+                Histograms &target = thread_metrics.*histograms;
+                auto it = std::find_if(target.begin(), target.end(), [name](const auto &item)
+                                       { return item.first == name; });
+                if (it == target.end())
+                {
+                    it = target.emplace(target.end(), std::string(name), LatencyHistogram(HISTOGRAM_BITS));
+                }
+                it->second.Record(nanoseconds);
+            }
+
+            void PrintLabel(std::ostream &out, std::string_view label, std::string_view value)
+            {
+                out << label << "=\""sv;
+                for (const char c : value)
+                {
+                    if (c == '"' || c == '\\')
+                    {
+                        out << '\\';
+                    }
+                    out << (c == '\n' ? ' ' : c);
+                }
+                out << '"';
+            }
+
+            // Границы корзин в наносекундах: 1, 2.5, 5 на каждый порядок от микросекунды до 10 секунд
+            std::vector<uint64_t> GetBucketBounds()
+            {
+                std::vector<uint64_t> bounds;
+                for (uint64_t scale = 1000; scale <= 1000000000; scale *= 10)
+                {
+                    bounds.insert(bounds.end(), {scale, scale * 5 / 2, scale * 5});
+                }
+                bounds.push_back(10000000000);
+                return bounds;
+            }
+        }
+
+        void RecordRequest(std::string_view type, uint64_t nanoseconds)
+        {
+            Record(&ThreadMetrics::requests, type, nanoseconds);
+        }
+
+        void RecordPhase(std::string_view phase, uint64_t nanoseconds)
+        {
+            Record(&ThreadMetrics::phases, phase, nanoseconds);
+        }
+
+        ScopedTimer::ScopedTimer(RecordFunction record, std::string_view name)
+            : record_(record), name_(name), start_(std::chrono::steady_clock::now()) {}
+
+        ScopedTimer::~ScopedTimer()
+        {
+            record_(name_, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count());
+        }
+
+        Snapshot Collect()
+        {
+            Registry &registry = GetRegistry();
+            std::lock_guard lock(registry.mutex);
+            Snapshot snapshot = registry.finished;
+            for (ThreadMetrics *thread_metrics : registry.threads)
+            {
+                std::lock_guard thread_lock(thread_metrics->mutex);
+                MergeInto(snapshot.requests, thread_metrics->requests);
+                MergeInto(snapshot.phases, thread_metrics->phases);
+            }
+            return snapshot;
+        }
+
+        void PrintPrometheus(const Snapshot &snapshot, std::ostream &out)
+        {
+            const auto seconds = [](double nanoseconds)
+            {
+                return nanoseconds / 1e9;
+            };
+
+            out << "# HELP catalogue_request_duration_seconds Time to answer a stat request.\n"sv
+                << "# TYPE catalogue_request_duration_seconds histogram\n"sv;
+            const std::vector<uint64_t> bounds = GetBucketBounds();
+            for (const auto &[type, histogram] : snapshot.requests)
+            {
+                for (const uint64_t bound : bounds)
+                {
+                    out << "catalogue_request_duration_seconds_bucket{"sv;
+                    PrintLabel(out, "type"sv, type);
+                    out << ",le=\""sv << seconds(bound) << "\"} "sv << histogram.GetCountAtOrBelow(bound) << '\n';
+                }
+                out << "catalogue_request_duration_seconds_bucket{"sv;
+                PrintLabel(out, "type"sv, type);
+                out << ",le=\"+Inf\"} "sv << histogram.GetCount() << '\n';
+
+                out << "catalogue_request_duration_seconds_sum{"sv;
+                PrintLabel(out, "type"sv, type);
+                out << "} "sv << seconds(histogram.GetMean() * histogram.GetCount()) << '\n';
+                out << "catalogue_request_duration_seconds_count{"sv;
+                PrintLabel(out, "type"sv, type);
+                out << "} "sv << histogram.GetCount() << '\n';
+            }
+
+            out << "# HELP catalogue_phase_duration_seconds Time spent in loading and preparation phases.\n"sv
+                << "# TYPE catalogue_phase_duration_seconds summary\n"sv;
+            for (const auto &[phase, histogram] : snapshot.phases)
+            {
+                out << "catalogue_phase_duration_seconds_sum{"sv;
+                PrintLabel(out, "phase"sv, phase);
+                out << "} "sv << seconds(histogram.GetMean() * histogram.GetCount()) << '\n';
+                out << "catalogue_phase_duration_seconds_count{"sv;
+                PrintLabel(out, "phase"sv, phase);
+                out << "} "sv << histogram.GetCount() << '\n';
+            }
+            out << "# HELP catalogue_phase_duration_max_seconds Longest run of a phase.\n"sv
+                << "# TYPE catalogue_phase_duration_max_seconds gauge\n"sv;
+            for (const auto &[phase, histogram] : snapshot.phases)
+            {
+                out << "catalogue_phase_duration_max_seconds{"sv;
+                PrintLabel(out, "phase"sv, phase);
+                out << "} "sv << seconds(histogram.GetMax()) << '\n';
+            }
+
+            out << "# HELP catalogue_route_cache_hits_total Route answers served from the cache.\n"sv
+                << "# TYPE catalogue_route_cache_hits_total counter\n"sv
+                << "catalogue_route_cache_hits_total "sv << snapshot.route_cache.hits << '\n'
+                << "# HELP catalogue_route_cache_misses_total Route answers computed by the router.\n"sv
+                << "# TYPE catalogue_route_cache_misses_total counter\n"sv
+                << "catalogue_route_cache_misses_total "sv << snapshot.route_cache.misses << '\n'
+                << "# HELP catalogue_route_cache_entries Routes currently cached.\n"sv
+                << "# TYPE catalogue_route_cache_entries gauge\n"sv
+                << "catalogue_route_cache_entries "sv << snapshot.route_cache.size << '\n';
+        }
+    }
+}
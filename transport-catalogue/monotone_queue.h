@@ -0,0 +1,109 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Двоичная куча с минимальным ключом наверху: очередь алгоритма Дейкстры для дробных весов
+template <typename Key, typename Value>
+class BinaryHeap {
+public:
+    void Push(Key key, Value value) {
+        items_.push_back({key, std::move(value)});
+        std::push_heap(items_.begin(), items_.end(), std::greater<Item>{});
+    }
+
+    std::pair<Key, Value> Pop() {
+        std::pop_heap(items_.begin(), items_.end(), std::greater<Item>{});
+        std::pair<Key, Value> top = std::move(items_.back());
+        items_.pop_back();
+        return top;
+    }
+
+    bool IsEmpty() const {
+        return items_.empty();
+    }
+
+    // Опустошает очередь, сохраняя выделенную память для следующего поиска
+    void Clear() {
+        items_.clear();
+    }
+
+private:
+    using Item = std::pair<Key, Value>;
+    std::vector<Item> items_;
+};
+
+// Поразрядная куча для неотрицательных целых ключей, если каждый добавленный ключ не меньше последнего извлечённого,
+// как в алгоритме Дейкстры и A* с согласованной оценкой. Запись лежит в корзине по старшему биту, которым её ключ
+// отличается от последнего извлечённого. Корзина 0 — ключи, равные ему, их можно отдавать сразу; иначе первая непустая
+// корзина раскладывается по меньшим от своего минимума. Запись опускается не больше 64 раз, а сравнения заменяются
+// одной инструкцией поиска старшего бита
+template <typename Value>
+class RadixHeap {
+public:
+    void Push(uint64_t key, Value value) {
+        if (key < last_) {
+            throw std::logic_error("RadixHeap keys must not decrease below the last popped key");
+        }
+        buckets_[GetBucket(key)].push_back({key, std::move(value)});
+        ++size_;
+    }
+
+    std::pair<uint64_t, Value> Pop() {
+        if (buckets_[0].empty()) {
+            size_t bucket = 1;
+            while (buckets_[bucket].empty()) {
+                ++bucket;
+            }
+            auto& source = buckets_[bucket];
+            last_ = source.front().first;
+            for (const auto& item : source) {
+                last_ = std::min(last_, item.first);
+            }
+            for (auto& item : source) {
+                buckets_[GetBucket(item.first)].push_back(std::move(item));
+            }
+            source.clear();
+        }
+        std::pair<uint64_t, Value> top = std::move(buckets_[0].back());
+        buckets_[0].pop_back();
+        --size_;
+        return top;
+    }
+
+    bool IsEmpty() const {
+        return size_ == 0;
+    }
+
+    // Опустошает очередь, сохраняя выделенную память для следующего поиска
+    void Clear() {
+        for (auto& bucket : buckets_) {
+            bucket.clear();
+        }
+        last_ = 0;
+        size_ = 0;
+    }
+
+private:
+    size_t GetBucket(uint64_t key) const {
+        return key == last_ ? 0 : 64 - __builtin_clzll(key ^ last_);
+    }
+
+    std::array<std::vector<std::pair<uint64_t, Value>>, 65> buckets_;
+    uint64_t last_ = 0;
+    size_t size_ = 0;
+};
+
+// Очередь для поиска кратчайших путей: поразрядная куча для целых весов, двоичная — для остальных
+template <typename Weight, typename Value>
+using MonotoneQueue = std::conditional_t<std::is_integral_v<Weight>, RadixHeap<Value>, BinaryHeap<Weight, Value>>;
+
+}  // namespace graph
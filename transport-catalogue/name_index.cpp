@@ -0,0 +1,258 @@
+#include "name_index.h"
+#include "memory_usage.h"
+
+#include <algorithm>
+#include <numeric>
+#include <tuple>
+
+namespace catalogue
+{
+    namespace
+    {
+        // Читает символ UTF-8, начинающийся в позиции pos, и сдвигает pos за него.
+        // Некорректный байт считается отдельным символом
+        char32_t NextCodePoint(std::string_view text, size_t &pos)
+        {
+            const unsigned char lead = text[pos];
+            size_t length = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2
+                                          : (lead >> 4) == 0xE   ? 3
+                                          : (lead >> 3) == 0x1E  ? 4
+                                                                 : 1;
+            if (pos + length > text.size())
+            {
+                length = 1;
+            }
+
+            char32_t code_point = length == 1 ? lead : lead & (0x7F >> length);
+            for (size_t i = 1; i < length; ++i)
+            {
+                code_point = (code_point << 6) | (static_cast<unsigned char>(text[pos + i]) & 0x3F);
+            }
+            pos += length;
+            return code_point;
+        }
+    }
+
+    std::string FoldCase(std::string_view text)
+    {
+        std::string result;
+        result.reserve(text.size());
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            const unsigned char c = text[i];
+            if (c >= 'A' && c <= 'Z')
+            {
+                result.push_back(static_cast<char>(c - 'A' + 'a'));
+                continue;
+            }
+
+            // Заглавные русские буквы: А-П -> D0 B0..BF, Р-Я -> D1 80..8F, Ё -> D1 91
+            if (c == 0xD0 && i + 1 < text.size())
+            {
+                const unsigned char next = text[++i];
+                if (next >= 0x90 && next <= 0x9F)
+                {
+                    result += {'\xD0', static_cast<char>(next + 0x20)};
+                }
+                else if (next >= 0xA0 && next <= 0xAF)
+                {
+                    result += {'\xD1', static_cast<char>(next - 0x20)};
+                }
+                else if (next == 0x81)
+                {
+                    result += "\xD1\x91";
+                }
+                else
+                {
+                    result += {'\xD0', static_cast<char>(next)};
+                }
+                continue;
+            }
+
+            result.push_back(static_cast<char>(c));
+        }
+        return result;
+    }
+
+    NameIndex::NameIndex(const std::vector<std::string_view> &stop_names, const std::vector<std::string_view> &bus_names)
+    {
+        std::vector<std::tuple<std::string, Kind, std::string_view>> names;
+        names.reserve(stop_names.size() + bus_names.size());
+        for (const auto name : stop_names)
+        {
+            names.emplace_back(FoldCase(name), Kind::STOP, name);
+        }
+        for (const auto name : bus_names)
+        {
+            names.emplace_back(FoldCase(name), Kind::BUS, name);
+        }
+        std::sort(names.begin(), names.end());
+
+        size_t keys_size = 0;
+        for (const auto &[key, kind, name] : names)
+        {
+            keys_size += key.size();
+        }
+        keys_.reserve(keys_size);
+        entries_.reserve(names.size());
+        for (const auto &[key, kind, name] : names)
+        {
+            entries_.push_back({static_cast<uint32_t>(keys_.size()), static_cast<uint32_t>(key.size()), name, kind});
+            keys_ += key;
+        }
+    }
+
+    std::string_view NameIndex::GetKey(const Entry &entry) const
+    {
+        return std::string_view(keys_).substr(entry.key_begin, entry.key_size);
+    }
+
+    size_t NameIndex::FindPrefixEnd(size_t first, std::string_view prefix) const
+    {
+        // Ключи от first и дальше не меньше prefix, поэтому начинающиеся с него идут подряд в начале
+        const auto it = std::partition_point(entries_.begin() + first, entries_.end(), [this, prefix](const Entry &entry)
+                                             { return GetKey(entry).substr(0, prefix.size()) == prefix; });
+        return it - entries_.begin();
+    }
+
+    std::vector<NameIndex::Match> NameIndex::FindByPrefix(std::string_view prefix, size_t limit) const
+    {
+        const auto it = std::partition_point(entries_.begin(), entries_.end(), [this, prefix](const Entry &entry)
+                                             { return GetKey(entry) < prefix; });
+        const size_t first = it - entries_.begin();
+        const size_t last = std::min(FindPrefixEnd(first, prefix), first + limit);
+
+        std::vector<Match> result;
+        result.reserve(last - first);
+        for (size_t i = first; i < last; ++i)
+        {
+            result.push_back({entries_[i].name, entries_[i].kind, 0});
+        }
+        return result;
+    }
+
+    std::vector<NameIndex::Match> NameIndex::Find(std::string_view query, int max_distance, size_t limit) const
+    {
+        const std::string folded_query = FoldCase(query);
+        max_distance = std::clamp(max_distance, 0, MAX_DISTANCE);
+        if (max_distance == 0 || limit == 0)
+        {
+            return FindByPrefix(folded_query, limit);
+        }
+
+        std::vector<char32_t> query_chars;
+        for (size_t pos = 0; pos < folded_query.size();)
+        {
+            query_chars.push_back(NextCodePoint(folded_query, pos));
+        }
+        const size_t width = query_chars.size() + 1;
+
+        // Состояние обхода для начала предыдущего ключа длиной depth символов:
+        // rows[depth * width + j] — расстояние между этим началом и первыми j символами запроса,
+        // best[depth] — наименьшее расстояние между запросом и началами ключа не длиннее depth символов,
+        // offsets[depth] — длина этого начала в байтах
+        std::vector<int> rows(width);
+        std::iota(rows.begin(), rows.end(), 0);
+        std::vector<int> best{rows.back()};
+        std::vector<size_t> offsets{0};
+        std::string_view previous_key;
+
+        // Найденные записи по расстоянию; названия дальше limit_distance уже не попадут в ответ
+        std::vector<std::vector<size_t>> found(max_distance + 1);
+        int limit_distance = max_distance;
+        const auto add_entries = [&](size_t first, size_t last, int distance)
+        {
+            if (distance > limit_distance)
+            {
+                return;
+            }
+            auto &bucket = found[distance];
+            for (size_t i = first; i < last && bucket.size() < limit; ++i)
+            {
+                bucket.push_back(i);
+            }
+
+            size_t count = 0;
+            for (int d = 0; d <= limit_distance; ++d)
+            {
+                count += found[d].size();
+                if (count >= limit)
+                {
+                    limit_distance = d - 1;
+                    break;
+                }
+            }
+        };
+
+        size_t entry = 0;
+        while (entry < entries_.size() && limit_distance >= 0)
+        {
+            // Строки таблицы для общего с предыдущим ключом начала остаются верными
+            const std::string_view key = GetKey(entries_[entry]);
+            const size_t common = std::mismatch(key.begin(), key.begin() + std::min(key.size(), previous_key.size()), previous_key.begin()).first - key.begin();
+            size_t depth = offsets.size() - 1;
+            while (offsets[depth] > common)
+            {
+                --depth;
+            }
+            offsets.resize(depth + 1);
+            best.resize(depth + 1);
+            rows.resize((depth + 1) * width);
+            previous_key = key;
+
+            size_t next_entry = entry + 1;
+            for (;;)
+            {
+                const int row_min = *std::min_element(rows.end() - width, rows.end());
+                if (row_min >= best[depth] || row_min > limit_distance)
+                {
+                    // Продолжения этого начала не приблизятся к запросу: у всех ключей с ним одно и то же расстояние
+                    next_entry = FindPrefixEnd(entry, key.substr(0, offsets[depth]));
+                    add_entries(entry, next_entry, best[depth]);
+                    break;
+                }
+                if (offsets[depth] == key.size())
+                {
+                    add_entries(entry, next_entry, best[depth]);
+                    break;
+                }
+
+                size_t pos = offsets[depth];
+                const char32_t c = NextCodePoint(key, pos);
+                offsets.push_back(pos);
+                rows.resize(rows.size() + width);
+                const int *previous = &rows[depth * width];
+                int *current = &rows[(depth + 1) * width];
+                current[0] = static_cast<int>(depth + 1);
+                for (size_t j = 1; j < width; ++j)
+                {
+                    current[j] = std::min({previous[j] + 1, current[j - 1] + 1, previous[j - 1] + (query_chars[j - 1] != c ? 1 : 0)});
+                }
+                best.push_back(std::min(best[depth], current[width - 1]));
+                ++depth;
+            }
+            entry = next_entry;
+        }
+
+        std::vector<Match> result;
+        for (int distance = 0; distance <= max_distance && result.size() < limit; ++distance)
+        {
+            for (size_t i = 0; i < found[distance].size() && result.size() < limit; ++i)
+            {
+                const Entry &found_entry = entries_[found[distance][i]];
+                result.push_back({found_entry.name, found_entry.kind, distance});
+            }
+        }
+        return result;
+    }
+
+    size_t NameIndex::GetSize() const
+    {
+        return entries_.size();
+    }
+
+    size_t NameIndex::GetMemoryUsage() const
+    {
+        return GetHeapBytes(keys_) + GetHeapBytes(entries_);
+    }
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace catalogue
+{
+    /*
+     * Поиск названий остановок и маршрутов по началу строки без учёта регистра.
+     * Названия в нижнем регистре лежат подряд в одной строке, записи упорядочены по ним,
+     * поэтому все названия с общим началом образуют непрерывный отрезок массива.
+     * Нечёткий поиск обходит этот массив как неявное префиксное дерево: строки таблицы
+     * редакционного расстояния для общего начала соседних названий не пересчитываются,
+     * а отрезки, в которых расстояние заведомо больше допустимого, пропускаются целиком
+     */
+    class NameIndex
+    {
+    public:
+        enum class Kind
+        {
+            STOP,
+            BUS,
+        };
+
+        struct Match
+        {
+            std::string_view name;
+            Kind kind;
+            // Наименьшее редакционное расстояние между запросом и началом названия
+            int distance;
+        };
+
+        static constexpr int MAX_DISTANCE = 2;
+
+        NameIndex() = default;
+
+        // Названия должны жить дольше индекса
+        NameIndex(const std::vector<std::string_view> &stop_names, const std::vector<std::string_view> &bus_names);
+
+        // Не больше limit названий, начало которых отличается от query не более чем на max_distance правок
+        // (вставка, удаление или замена символа; max_distance ограничено MAX_DISTANCE).
+        // Сначала идут более близкие названия, при равном расстоянии — в алфавитном порядке без учёта регистра
+        std::vector<Match> Find(std::string_view query, int max_distance, size_t limit) const;
+
+        size_t GetSize() const;
+
+        size_t GetMemoryUsage() const;
+
+    private:
+        struct Entry
+        {
+            // Название в нижнем регистре: keys_[key_begin..key_begin + key_size)
+            uint32_t key_begin;
+            uint32_t key_size;
+            std::string_view name;
+            Kind kind;
+        };
+
+        std::string_view GetKey(const Entry &entry) const;
+
+        // Конец отрезка записей, начиная с first, ключи которых начинаются с prefix
+        size_t FindPrefixEnd(size_t first, std::string_view prefix) const;
+
+        std::vector<Match> FindByPrefix(std::string_view prefix, size_t limit) const;
+
+        std::string keys_;
+        std::vector<Entry> entries_;
+    };
+
+    // Переводит латинские и русские буквы UTF-8 в нижний регистр, остальные байты не меняет
+    std::string FoldCase(std::string_view text);
+}
@@ -0,0 +1,207 @@
+#include "raptor.h"
+
+#include "memory_usage.h"
+#include "metrics.h"
+#include "transport_router.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace catalogue
+{
+    namespace router
+    {
+        namespace
+        {
+            const double MINUTES_PER_DAY = 24.0 * 60.0;
+            const double INFINITE_TIME = std::numeric_limits<double>::infinity();
+        }
+
+        RaptorRouter::RaptorRouter(const RouterSettings &rout_sett, const TransportCatalogue &catalogue)
+        {
+            metrics::ScopedTimer timer(metrics::RecordPhase, "build_raptor");
+            for (const auto &stop : catalogue.GetStopList())
+            {
+                stop_index_[stop.get()] = stops_.size();
+                stops_.push_back(stop.get());
+            }
+
+            const double meters_per_minute = rout_sett.bus_velocity * 1000.0 / 60.0;
+            const double interval = std::max(rout_sett.wait_time, 1.0);
+            std::vector<std::vector<StopRoute>> routes_by_stop(stops_.size());
+            for (const auto &bus : catalogue.GetBusList())
+            {
+                const auto &stops = bus->bus_stops;
+                if (stops.empty())
+                {
+                    continue;
+                }
+
+                const uint32_t route = routes_.size();
+                routes_.push_back({bus.get(), uint32_t(route_stops_.size()), uint32_t(stops.size()), uint32_t(trip_departures_.size()), 0});
+                Route &added = routes_.back();
+
+                double distance = 0.0;
+                for (size_t i = 0; i < stops.size(); ++i)
+                {
+                    if (i > 0)
+                    {
+                        distance += catalogue.GetDistance(stops[i - 1], stops[i]);
+                    }
+                    const uint32_t stop = stop_index_.at(stops[i]);
+                    routes_by_stop[stop].push_back({route, uint32_t(i)});
+                    route_stops_.push_back(stop);
+                    route_times_.push_back(distance / meters_per_minute);
+                }
+
+                if (bus->departures.empty())
+                {
+                    for (double departure = 0.0; departure < MINUTES_PER_DAY; departure += interval)
+                    {
+                        trip_departures_.push_back(departure);
+                    }
+                }
+                else
+                {
+                    trip_departures_.insert(trip_departures_.end(), bus->departures.begin(), bus->departures.end());
+                    std::sort(trip_departures_.begin() + added.first_trip, trip_departures_.end());
+                }
+                added.trip_count = trip_departures_.size() - added.first_trip;
+            }
+
+            stop_routes_begin_.reserve(stops_.size() + 1);
+            for (const auto &stop_routes : routes_by_stop)
+            {
+                stop_routes_begin_.push_back(stop_routes_.size());
+                stop_routes_.insert(stop_routes_.end(), stop_routes.begin(), stop_routes.end());
+            }
+            stop_routes_begin_.push_back(stop_routes_.size());
+        }
+
+        std::optional<RaptorRouter::RouteInfo> RaptorRouter::GetEarliestArrivalRoute(const Stop *from, const Stop *to, double departure_time) const
+        {
+            const uint32_t source = stop_index_.at(from);
+            const uint32_t target = stop_index_.at(to);
+            const size_t stop_count = stops_.size();
+
+            // Метки раунда k занимают labels[k * stop_count, (k + 1) * stop_count)
+            std::vector<Label> labels(stop_count, Label{INFINITE_TIME});
+            std::vector<double> best_arrival(stop_count, INFINITE_TIME);
+            labels[source].arrival = departure_time;
+            best_arrival[source] = departure_time;
+
+            std::vector<uint32_t> marked_stops{source};
+            std::vector<bool> is_marked(stop_count, false);
+            std::vector<uint32_t> first_position(routes_.size(), NO_INDEX);
+            std::vector<uint32_t> queued_routes;
+
+            uint32_t round = 0;
+            while (!marked_stops.empty())
+            {
+                ++round;
+                for (const uint32_t stop : marked_stops)
+                {
+                    is_marked[stop] = false;
+                    for (uint32_t i = stop_routes_begin_[stop]; i < stop_routes_begin_[stop + 1]; ++i)
+                    {
+                        const auto [route, position] = stop_routes_[i];
+                        if (first_position[route] == NO_INDEX)
+                        {
+                            queued_routes.push_back(route);
+                            first_position[route] = position;
+                        }
+                        first_position[route] = std::min(first_position[route], position);
+                    }
+                }
+                marked_stops.clear();
+
+                // Метки нового раунда начинаются с меток предыдущего
+                labels.resize((round + 1) * stop_count);
+                std::copy(labels.end() - 2 * stop_count, labels.end() - stop_count, labels.end() - stop_count);
+                const Label *previous = labels.data() + (round - 1) * stop_count;
+                Label *current = labels.data() + round * stop_count;
+
+                for (const uint32_t route_index : queued_routes)
+                {
+                    const Route &route = routes_[route_index];
+                    const double *departures_begin = trip_departures_.data() + route.first_trip;
+                    const double *departures_end = departures_begin + route.trip_count;
+
+                    uint32_t trip = NO_INDEX;
+                    uint32_t board_position = 0;
+                    for (uint32_t position = first_position[route_index]; position < route.stop_count; ++position)
+                    {
+                        const uint32_t stop = route_stops_[route.first_stop + position];
+                        const double offset = route_times_[route.first_stop + position];
+
+                        if (trip != NO_INDEX)
+                        {
+                            const double arrival = departures_begin[trip] + offset;
+                            if (arrival < std::min(best_arrival[stop], best_arrival[target]))
+                            {
+                                current[stop] = {arrival, round, route_index, board_position, position, trip};
+                                best_arrival[stop] = arrival;
+                                if (!is_marked[stop])
+                                {
+                                    is_marked[stop] = true;
+                                    marked_stops.push_back(stop);
+                                }
+                            }
+                        }
+
+                        // Если на остановку можно было попасть раньше этого рейса, пробуем сесть на более ранний
+                        const double ready_time = previous[stop].arrival;
+                        if (ready_time == INFINITE_TIME || (trip != NO_INDEX && departures_begin[trip] + offset < ready_time))
+                        {
+                            continue;
+                        }
+                        const double *earliest = std::lower_bound(departures_begin, departures_end, ready_time - offset);
+                        if (earliest != departures_end && (trip == NO_INDEX || uint32_t(earliest - departures_begin) < trip))
+                        {
+                            trip = earliest - departures_begin;
+                            board_position = position;
+                        }
+                    }
+                    first_position[route_index] = NO_INDEX;
+                }
+                queued_routes.clear();
+            }
+
+            if (best_arrival[target] == INFINITE_TIME)
+            {
+                return std::nullopt;
+            }
+            return MakeRouteInfo(labels, round, target);
+        }
+
+        RaptorRouter::RouteInfo RaptorRouter::MakeRouteInfo(const std::vector<Label> &labels, uint32_t round, uint32_t to) const
+        {
+            const size_t stop_count = stops_.size();
+            RouteInfo route_info;
+            Label label = labels[round * stop_count + to];
+            while (label.route != NO_INDEX)
+            {
+                const Route &route = routes_[label.route];
+                const uint32_t board_stop = route_stops_[route.first_stop + label.board_position];
+                const double board_offset = route_times_[route.first_stop + label.board_position];
+                const double alight_offset = route_times_[route.first_stop + label.alight_position];
+                const double board_time = trip_departures_[route.first_trip + label.trip] + board_offset;
+
+                // Предыдущий отрезок поездки — метка остановки посадки на раунд раньше
+                const Label &previous = labels[(label.round - 1) * stop_count + board_stop];
+                route_info.push_back({0, 0, alight_offset - board_offset, int(label.alight_position - label.board_position), route.bus->bus_name});
+                route_info.push_back({0, 0, board_time - previous.arrival, 0, stops_[board_stop]->stop_name});
+                label = previous;
+            }
+
+            std::reverse(route_info.begin(), route_info.end());
+            return route_info;
+        }
+
+        size_t RaptorRouter::GetMemoryUsage() const
+        {
+            return stop_index_.GetMemoryUsage() + GetHeapBytes(stops_) + GetHeapBytes(routes_) + GetHeapBytes(route_stops_) + GetHeapBytes(route_times_)
+                   + GetHeapBytes(trip_departures_) + GetHeapBytes(stop_routes_begin_) + GetHeapBytes(stop_routes_);
+        }
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "flat_hash_map.h"
+#include "graph.h"
+#include "transport_catalogue.h"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace catalogue
+{
+    namespace router
+    {
+        struct RouterSettings;
+
+        /*
+         * Поиск самого раннего прибытия по расписанию (алгоритм RAPTOR).
+         * Каждый раунд просматривает маршруты, проходящие через остановки, улучшенные в прошлом раунде,
+         * поэтому раунд k находит лучшие поездки ровно с k посадками. Предподсчёт сводится к раскладке
+         * маршрутов, рейсов и остановок по плоским массивам, которые просматриваются последовательно.
+         * Рейсы маршрута отличаются только временем отправления и не обгоняют друг друга.
+         * Маршрут без расписания считается отправляющимся с первой остановки каждые wait_time минут круглые сутки
+         */
+        class RaptorRouter
+        {
+        public:
+            using RouteInfo = std::vector<graph::Edge<double>>;
+
+            RaptorRouter(const RouterSettings &rout_sett, const TransportCatalogue &catalogue);
+
+            // Поездка с самым ранним прибытием при отправлении не раньше departure_time (в минутах от начала суток).
+            // Из поездок с одинаковым прибытием выбирается поездка с меньшим числом пересадок.
+            // Время ожидания в элементах Wait — фактическое ожидание рейса
+            std::optional<RouteInfo> GetEarliestArrivalRoute(const Stop *from, const Stop *to, double departure_time) const;
+
+            size_t GetMemoryUsage() const;
+
+        private:
+            static constexpr uint32_t NO_INDEX = UINT32_MAX;
+
+            struct Route
+            {
+                const Bus *bus;
+                // Начало остановок маршрута в route_stops_ и route_times_
+                uint32_t first_stop;
+                uint32_t stop_count;
+                // Начало отправлений маршрута в trip_departures_
+                uint32_t first_trip;
+                uint32_t trip_count;
+            };
+
+            struct StopRoute
+            {
+                uint32_t route;
+                // Номер остановки внутри маршрута
+                uint32_t position;
+            };
+
+            // Лучшее прибытие на остановку за раунд и последний отрезок поездки
+            struct Label
+            {
+                double arrival;
+                // Раунд, в котором метка получена; в следующие раунды она копируется
+                uint32_t round = 0;
+                uint32_t route = NO_INDEX;
+                uint32_t board_position = 0;
+                uint32_t alight_position = 0;
+                uint32_t trip = 0;
+            };
+
+            RouteInfo MakeRouteInfo(const std::vector<Label> &labels, uint32_t round, uint32_t to) const;
+
+            FlatHashMap<const Stop *, uint32_t> stop_index_;
+            std::vector<const Stop *> stops_;
+
+            std::vector<Route> routes_;
+            std::vector<uint32_t> route_stops_;
+            // Время в пути от первой остановки маршрута, параллельно route_stops_
+            std::vector<double> route_times_;
+            std::vector<double> trip_departures_;
+
+            // Маршруты через каждую остановку: stop_routes_[stop_routes_begin_[s]..stop_routes_begin_[s + 1])
+            std::vector<uint32_t> stop_routes_begin_;
+            std::vector<StopRoute> stop_routes_;
+        };
+    }
+}
@@ -1,42 +1,63 @@
 #include "request_handler.h"
 
 #include <algorithm>
-#include <map>
 
 namespace catalogue
 {
-    RequestHandler::RequestHandler(const TransportCatalogue &db, const renderer::MapRenderer &renderer, const router::TransportRouter &router)
-        : db_(db), renderer_(renderer), router_(router) {}
+    RequestHandler::RequestHandler(const TransportCatalogue &db, const renderer::MapRenderer &renderer, const router::TransportRouter &router, ThreadPool *render_pool)
+        : db_(db), renderer_(renderer), router_(router), render_pool_(render_pool) {}
 
-    svg::Document RequestHandler::RenderMap() const
+    RequestHandler::MapData RequestHandler::CollectMapData() const
     {
-        svg::Document result;
-        std::vector<geo::Coordinates> stop_coords;
-        std::map<std::string_view, geo::Coordinates> stops;
+        MapData data;
         for (const auto &bus : db_.GetBusList())
         {
-            for (const auto &stop : bus.bus_stops)
+            for (const auto &stop : bus->bus_stops)
             {
                 const auto &coord = stop->coords;
-                stop_coords.push_back({coord.lat, coord.lng});
-                stops.insert({stop->stop_name, coord});
+                data.stop_coords.push_back({coord.lat, coord.lng});
+                data.stops.insert({stop->stop_name, coord});
             }
         }
 
-        std::vector<std::string_view> buses;
-        const std::unordered_map<std::string_view, const Bus *> &busname_to_bus = db_.GetBusNameToBus();
         for (const auto &bus : db_.GetBusList())
         {
-            buses.push_back(bus.bus_name);
+            data.buses.push_back(bus->bus_name);
         }
-        std::sort(buses.begin(), buses.end());
+        std::sort(data.buses.begin(), data.buses.end());
 
-        if (!buses.empty())
+        return data;
+    }
+
+    void RequestHandler::RenderMap(std::ostream &out) const
+    {
+        metrics::ScopedTimer timer(metrics::RecordPhase, "render");
+        const MapData data = CollectMapData();
+        svg::StreamWriter writer = renderer_.MakeWriter(out);
+        if (render_pool_)
         {
-            result = renderer_.RenderMap(stop_coords, buses, busname_to_bus, stops);
+            renderer_.RenderMap(writer, *render_pool_, data.stop_coords, data.buses, db_.GetBusNameToBus(), data.stops);
         }
+        else
+        {
+            renderer_.RenderMap(writer, data.stop_coords, data.buses, db_.GetBusNameToBus(), data.stops);
+        }
+    }
 
-        return result;
+    void RequestHandler::RenderMap(std::ostream &out, const geo::BoundingBox &viewport) const
+    {
+        metrics::ScopedTimer timer(metrics::RecordPhase, "render");
+        std::call_once(spatial_index_flag_, [this]
+                       {
+                           std::vector<const Bus *> buses;
+                           for (const auto &bus : db_.GetBusList())
+                           {
+                               buses.push_back(bus.get());
+                           }
+                           spatial_index_ = std::make_unique<renderer::SpatialIndex>(std::move(buses)); });
+
+        svg::StreamWriter writer = renderer_.MakeWriter(out);
+        renderer_.RenderMap(writer, viewport, *spatial_index_);
     }
 
     const Stop *RequestHandler::FindStop(std::string_view name) const
@@ -44,7 +65,7 @@ namespace catalogue
         return db_.FindStop(name);
     }
 
-    const std::unordered_set<const Bus *> &RequestHandler::GetStopInfo(std::string_view name) const
+    TransportCatalogue::BusRange RequestHandler::GetStopInfo(std::string_view name) const
     {
         return db_.GetStopInfo(name);
     }
@@ -54,8 +75,39 @@ namespace catalogue
         return db_.GetBusInfo(name);
     }
 
+    std::vector<NameIndex::Match> RequestHandler::FindNames(std::string_view query, int max_distance, size_t limit) const
+    {
+        return db_.GetNameIndex().Find(query, max_distance, limit);
+    }
+
+    metrics::Snapshot RequestHandler::GetStats() const
+    {
+        metrics::Snapshot snapshot = metrics::Collect();
+        const auto cache = router_.GetRouteCacheStats();
+        snapshot.route_cache = {cache.hits, cache.misses, cache.size};
+        return snapshot;
+    }
+
+    MemoryUsage RequestHandler::GetMemoryUsage() const
+    {
+        MemoryUsage usage;
+        db_.AddMemoryUsage(usage);
+        router_.AddMemoryUsage(usage);
+        return usage;
+    }
+
     std::optional<RequestHandler::RouteInfo> RequestHandler::GetShortestRoute(const Stop *from, const Stop *to) const
     {
         return router_.GetShortestRoute(from, to);
     }
+
+    std::vector<RequestHandler::RouteInfo> RequestHandler::GetAlternativeRoutes(const Stop *from, const Stop *to, size_t count) const
+    {
+        return router_.GetAlternativeRoutes(from, to, count);
+    }
+
+    std::optional<RequestHandler::RouteInfo> RequestHandler::GetEarliestArrivalRoute(const Stop *from, const Stop *to, double departure_time) const
+    {
+        return router_.GetEarliestArrivalRoute(from, to, departure_time);
+    }
 }
\ No newline at end of file
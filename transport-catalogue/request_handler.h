@@ -1,9 +1,14 @@
 #pragma once
 
 #include "map_renderer.h"
+#include "metrics.h"
 #include "transport_catalogue.h"
 #include "transport_router.h"
 
+#include <map>
+#include <memory>
+#include <mutex>
+
 namespace catalogue
 {
     class RequestHandler
@@ -11,21 +16,55 @@ namespace catalogue
     public:
         using RouteInfo = router::TransportRouter::RouteInfo;
 
-        RequestHandler(const TransportCatalogue &db, const renderer::MapRenderer &renderer, const router::TransportRouter &router);
+        // Если задан render_pool, слои карты готовятся в нём параллельно
+        RequestHandler(const TransportCatalogue &db, const renderer::MapRenderer &renderer, const router::TransportRouter &router, ThreadPool *render_pool = nullptr);
+
+        // Выводит карту в поток
+        void RenderMap(std::ostream &out) const;
 
-        svg::Document RenderMap() const;
+        // Выводит часть карты, попадающую в область viewport
+        void RenderMap(std::ostream &out, const geo::BoundingBox &viewport) const;
 
         const Stop *FindStop(std::string_view name) const;
 
         BusInfo GetBusInfo(std::string_view name) const;
 
-        const std::unordered_set<const Bus *> &GetStopInfo(std::string_view name) const;
+        TransportCatalogue::BusRange GetStopInfo(std::string_view name) const;
+
+        // Остановки и маршруты, названия которых начинаются с query с точностью до max_distance правок
+        std::vector<NameIndex::Match> FindNames(std::string_view query, int max_distance, size_t limit) const;
+
+        // Задержки запросов и длительности этапов всех потоков вместе со статистикой кэша маршрутов
+        metrics::Snapshot GetStats() const;
+
+        // Память справочника и маршрутизатора по структурам
+        MemoryUsage GetMemoryUsage() const;
 
         std::optional<RouteInfo> GetShortestRoute(const Stop *from, const Stop *to) const;
 
+        std::vector<RouteInfo> GetAlternativeRoutes(const Stop *from, const Stop *to, size_t count) const;
+
+        // Поездка по расписанию с отправлением не раньше departure_time
+        std::optional<RouteInfo> GetEarliestArrivalRoute(const Stop *from, const Stop *to, double departure_time) const;
+
     private:
+        // Данные справочника, из которых строится карта
+        struct MapData
+        {
+            std::vector<geo::Coordinates> stop_coords;
+            std::map<std::string_view, geo::Coordinates> stops;
+            std::vector<std::string_view> buses;
+        };
+
+        MapData CollectMapData() const;
+
         const TransportCatalogue &db_;
         const renderer::MapRenderer &renderer_;
         const router::TransportRouter &router_;
+        ThreadPool *render_pool_;
+
+        // Индекс строится при первом запросе части карты
+        mutable std::once_flag spatial_index_flag_;
+        mutable std::unique_ptr<renderer::SpatialIndex> spatial_index_;
     };
 }
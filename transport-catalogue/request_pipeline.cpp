@@ -0,0 +1,128 @@
+#include "request_pipeline.h"
+
+#include <sstream>
+
+namespace catalogue
+{
+    namespace json
+    {
+        using namespace std::literals;
+
+        RequestPipeline::RequestPipeline(RequestHandler &request_handler, std::ostream &out, size_t worker_count, size_t depth)
+            : request_handler_(request_handler), out_(out), depth_(depth > 0 ? depth : 1), tasks_(depth_)
+        {
+            out_ << '[';
+
+            if (worker_count == 0)
+            {
+                worker_count = 1;
+            }
+            workers_.reserve(worker_count);
+            for (size_t i = 0; i < worker_count; ++i)
+            {
+                workers_.emplace_back([this]
+                                      { Work(); });
+            }
+            writer_ = std::thread([this]
+                                  { Write(); });
+        }
+
+        RequestPipeline::~RequestPipeline()
+        {
+            Finish();
+        }
+
+        void RequestPipeline::Push(StatRequests request)
+        {
+            uint64_t sequence;
+            {
+                std::unique_lock lock(mutex_);
+                has_room_.wait(lock, [this]
+                               { return next_sequence_ - written_count_ < depth_; });
+                sequence = next_sequence_++;
+            }
+            tasks_.Push({sequence, std::move(request)});
+        }
+
+        void RequestPipeline::Finish()
+        {
+            if (is_finished_)
+            {
+                return;
+            }
+            is_finished_ = true;
+
+            tasks_.Close();
+            for (auto &worker : workers_)
+            {
+                worker.join();
+            }
+            {
+                std::lock_guard lock(mutex_);
+                is_finishing_ = true;
+            }
+            has_result_.notify_one();
+            writer_.join();
+
+            out_ << "\n]"sv;
+        }
+
+        void RequestPipeline::Work()
+        {
+            while (auto task = tasks_.Pop())
+            {
+                std::string response = Answer(task->request);
+                {
+                    std::lock_guard lock(mutex_);
+                    results_.emplace(task->sequence, std::move(response));
+                }
+                has_result_.notify_one();
+            }
+        }
+
+        void RequestPipeline::Write()
+        {
+            std::unique_lock lock(mutex_);
+            while (true)
+            {
+                has_result_.wait(lock, [this]
+                                 { return results_.count(written_count_) > 0 || (is_finishing_ && written_count_ == next_sequence_); });
+                const auto it = results_.find(written_count_);
+                if (it == results_.end())
+                {
+                    return;
+                }
+
+                const std::string response = std::move(it->second);
+                results_.erase(it);
+
+                // Вывод идёт без блокировки, чтобы рабочие потоки могли сдавать ответы
+                lock.unlock();
+                out_ << (written_count_ == 0 ? "\n"sv : ",\n"sv) << response;
+                lock.lock();
+
+                ++written_count_;
+                has_room_.notify_one();
+            }
+        }
+
+        std::string RequestPipeline::Answer(const StatRequests &request) const
+        {
+            std::ostringstream out;
+            PrintIndent(out, 1);
+            try
+            {
+                PrintResponse(request_handler_, request, out);
+            }
+            catch (const std::exception &e)
+            {
+                // Остальные ответы PrintResponse заменяет сам. Карта здесь пишется в строку, поэтому и её
+                // незаконченный вывод можно заменить, а не прерывать весь ответ, как при выводе сразу в поток
+                out.str({});
+                PrintIndent(out, 1);
+                PrintNode(GetErrorResponse(request.id, e), out, 1);
+            }
+            return out.str();
+        }
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "bounded_queue.h"
+#include "json_reader.h"
+#include "request_handler.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace catalogue
+{
+    namespace json
+    {
+        /*
+         * Конвейер ответов на stat_requests: запросы поступают по мере разбора входа,
+         * выполняются в нескольких потоках, а ответы выводятся в порядке поступления запросов.
+         * Одновременно в работе находится не больше depth запросов, поэтому память не зависит от их общего числа.
+         * Вывод совпадает с PrintOutput для той же последовательности запросов
+         */
+        class RequestPipeline
+        {
+        public:
+            RequestPipeline(RequestHandler &request_handler, std::ostream &out, size_t worker_count, size_t depth);
+            ~RequestPipeline();
+
+            RequestPipeline(const RequestPipeline &) = delete;
+            RequestPipeline &operator=(const RequestPipeline &) = delete;
+
+            // Передаёт запрос в работу. Ждёт, если в работе уже depth запросов
+            void Push(StatRequests request);
+
+            // Дожидается вывода всех ответов и закрывает массив
+            void Finish();
+
+        private:
+            struct Task
+            {
+                uint64_t sequence;
+                StatRequests request;
+            };
+
+            void Work();
+
+            void Write();
+
+            std::string Answer(const StatRequests &request) const;
+
+            RequestHandler &request_handler_;
+            std::ostream &out_;
+            const size_t depth_;
+
+            BoundedQueue<Task> tasks_;
+
+            std::mutex mutex_;
+            std::condition_variable has_result_;
+            std::condition_variable has_room_;
+            // Готовые ответы, которые ждут вывода более ранних
+            std::map<uint64_t, std::string> results_;
+            uint64_t next_sequence_ = 0;
+            uint64_t written_count_ = 0;
+            bool is_finishing_ = false;
+            bool is_finished_ = false;
+
+            std::vector<std::thread> workers_;
+            std::thread writer_;
+        };
+    }
+}
@@ -1,12 +1,16 @@
 #pragma once
 
 #include "graph.h"
+#include "monotone_queue.h"
 
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <functional>
 #include <iterator>
+#include <memory_resource>
 #include <optional>
+#include <set>
 #include <stdexcept>
 #include <unordered_map>
 #include <utility>
@@ -20,7 +24,12 @@ private:
     using Graph = DirectedWeightedGraph<Weight>;
 
 public:
-    explicit Router(const Graph& graph);
+    // Таблица маршрутов размещается в resource: она строится один раз и занимает больше всего памяти
+    explicit Router(const Graph& graph, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    // Копирует предпосчитанные маршруты other для копии его графа
+    Router(const Graph& graph, const Router& other,
+           std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 
     struct RouteInfo {
         Weight weight;
@@ -29,12 +38,30 @@ public:
 
     std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
 
+    // До count различных маршрутов без повторных вершин в порядке возрастания веса; первый — кратчайший.
+    // Маршрут-кандидат проходит по дереву кратчайших путей из from до промежуточной вершины, а дальше —
+    // по кратчайшему пути до to. Вершины одного плато (общего участка дерева из from и путей к to) дают
+    // один и тот же маршрут, поэтому повторы отбрасываются. Дополнительных поисков по графу не требуется.
+    // Если задан is_acceptable, запасные маршруты, которые он отвергает, тоже отбрасываются
+    std::vector<RouteInfo> BuildAlternativeRoutes(
+        VertexId from, VertexId to, size_t count,
+        const std::function<bool(const std::vector<EdgeId>&)>& is_acceptable = nullptr) const;
+
+    // Обновляет маршруты после изменения весов рёбер графа; changed_edges — рёбра и их прежние веса.
+    // Маршруты из вершины пересчитываются, только если её дерево кратчайших путей содержит изменённое
+    // ребро или подешевевшее ребро даёт более короткий путь. Остальные строки остаются оптимальными.
+    // Проверка строки смотрит только на концы изменённых рёбер, так что отбор строк стоит O(V * |changed_edges|)
+    void UpdateEdgeWeights(const std::vector<std::pair<EdgeId, Weight>>& changed_edges);
+
+    // Байты, занятые предпосчитанными маршрутами: квадратично по числу вершин
+    size_t GetMemoryUsage() const;
+
 private:
     struct RouteInternalData {
         Weight weight;
         std::optional<EdgeId> prev_edge;
     };
-    using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
+    using RoutesInternalData = std::pmr::vector<std::pmr::vector<std::optional<RouteInternalData>>>;
 
     void InitializeRoutesInternalData(const Graph& graph) {
         const size_t vertex_count = graph.GetVertexCount();
@@ -75,25 +102,147 @@ private:
         }
     }
 
+    // Ребро входит в дерево кратчайших путей строки, только если оно последнее на пути к своему концу,
+    // поэтому для каждого изменённого ребра достаточно посмотреть две ячейки строки
+    bool IsRouteRowAffected(VertexId vertex_from, const std::vector<EdgeId>& changed_edges,
+                            const std::vector<bool>& is_decreased) const {
+        const auto& row = routes_internal_data_[vertex_from];
+        for (const EdgeId edge_id : changed_edges) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            const auto& route_to_edge = row[edge.from];
+            if (!route_to_edge) {
+                continue;
+            }
+            const auto& route_through_edge = row[edge.to];
+            if (route_through_edge && route_through_edge->prev_edge == edge_id) {
+                return true;
+            }
+            if (is_decreased[edge_id]
+                && (!route_through_edge || route_to_edge->weight + edge.weight < route_through_edge->weight)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Пересчитывает маршруты из одной вершины алгоритмом Дейкстры
+    void RecomputeRouteRow(VertexId vertex_from) {
+        auto& row = routes_internal_data_[vertex_from];
+        std::fill(row.begin(), row.end(), std::nullopt);
+        row[vertex_from] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
+
+        MonotoneQueue<Weight, VertexId> queue;
+        queue.Push(ZERO_WEIGHT, vertex_from);
+        while (!queue.IsEmpty()) {
+            const auto [key, vertex] = queue.Pop();
+            const Weight weight = static_cast<Weight>(key);
+            if (row[vertex]->weight < weight) {
+                continue;
+            }
+            for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                const Weight candidate_weight = weight + edge.weight;
+                auto& route = row[edge.to];
+                if (!route || candidate_weight < route->weight) {
+                    route = RouteInternalData{candidate_weight, edge_id};
+                    queue.Push(candidate_weight, edge.to);
+                }
+            }
+        }
+    }
+
+    std::vector<EdgeId> CollectRouteEdges(VertexId from, VertexId to) const {
+        std::vector<EdgeId> edges;
+        for (std::optional<EdgeId> edge_id = routes_internal_data_[from][to]->prev_edge;
+             edge_id;
+             edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
+        {
+            edges.push_back(*edge_id);
+        }
+        std::reverse(edges.begin(), edges.end());
+        return edges;
+    }
+
+    bool IsLoopFree(VertexId from, const std::vector<EdgeId>& edges, std::vector<bool>& is_visited) const {
+        bool is_loop_free = true;
+        is_visited[from] = true;
+        for (const EdgeId edge_id : edges) {
+            const VertexId vertex = graph_.GetEdge(edge_id).to;
+            is_loop_free = is_loop_free && !is_visited[vertex];
+            is_visited[vertex] = true;
+        }
+        is_visited[from] = false;
+        for (const EdgeId edge_id : edges) {
+            is_visited[graph_.GetEdge(edge_id).to] = false;
+        }
+        return is_loop_free;
+    }
+
     static constexpr Weight ZERO_WEIGHT{};
     const Graph& graph_;
     RoutesInternalData routes_internal_data_;
 };
 
 template <typename Weight>
-Router<Weight>::Router(const Graph& graph)
+Router<Weight>::Router(const Graph& graph, std::pmr::memory_resource* resource)
     : graph_(graph)
-    , routes_internal_data_(graph.GetVertexCount(),
-                            std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
+    , routes_internal_data_(resource)
 {
+    // Строки создаются на месте: образец строки для копирования остался бы в монотонной арене лишним
+    const size_t vertex_count = graph.GetVertexCount();
+    routes_internal_data_.reserve(vertex_count);
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        routes_internal_data_.emplace_back(vertex_count);
+    }
     InitializeRoutesInternalData(graph);
 
-    const size_t vertex_count = graph.GetVertexCount();
     for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
         RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
     }
 }
 
+template <typename Weight>
+Router<Weight>::Router(const Graph& graph, const Router& other, std::pmr::memory_resource* resource)
+    : graph_(graph)
+    , routes_internal_data_(other.routes_internal_data_, resource)
+{
+}
+
+template <typename Weight>
+size_t Router<Weight>::GetMemoryUsage() const {
+    size_t bytes = routes_internal_data_.capacity() * sizeof(typename RoutesInternalData::value_type);
+    for (const auto& row : routes_internal_data_) {
+        bytes += row.capacity() * sizeof(typename RoutesInternalData::value_type::value_type);
+    }
+    return bytes;
+}
+
+template <typename Weight>
+void Router<Weight>::UpdateEdgeWeights(const std::vector<std::pair<EdgeId, Weight>>& changed_edges) {
+    std::vector<EdgeId> changed_edge_ids;
+    std::vector<bool> is_decreased(graph_.GetEdgeCount(), false);
+    for (const auto& [edge_id, old_weight] : changed_edges) {
+        const Weight weight = graph_.GetEdge(edge_id).weight;
+        if (weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+        changed_edge_ids.push_back(edge_id);
+        is_decreased[edge_id] = weight < old_weight;
+    }
+
+    // Решение по каждой строке принимается по старым значениям, поэтому строки сначала отбираются, а потом пересчитываются
+    const size_t vertex_count = graph_.GetVertexCount();
+    std::vector<VertexId> affected_rows;
+    for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
+        if (IsRouteRowAffected(vertex_from, changed_edge_ids, is_decreased)) {
+            affected_rows.push_back(vertex_from);
+        }
+    }
+    for (const VertexId vertex_from : affected_rows) {
+        RecomputeRouteRow(vertex_from);
+    }
+}
+
 template <typename Weight>
 std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
                                                                              VertexId to) const {
@@ -101,17 +250,50 @@ std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(Ver
     if (!route_internal_data) {
         return std::nullopt;
     }
-    const Weight weight = route_internal_data->weight;
-    std::vector<EdgeId> edges;
-    for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-         edge_id;
-         edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
-    {
-        edges.push_back(*edge_id);
+    return RouteInfo{route_internal_data->weight, CollectRouteEdges(from, to)};
+}
+
+template <typename Weight>
+std::vector<typename Router<Weight>::RouteInfo> Router<Weight>::BuildAlternativeRoutes(
+    VertexId from, VertexId to, size_t count,
+    const std::function<bool(const std::vector<EdgeId>&)>& is_acceptable) const {
+    std::vector<RouteInfo> routes;
+    const auto& routes_from = routes_internal_data_.at(from);
+    if (count == 0 || !routes_from.at(to)) {
+        return routes;
     }
-    std::reverse(edges.begin(), edges.end());
+    // Первым идёт тот же маршрут, что возвращает BuildRoute
+    routes.push_back(*BuildRoute(from, to));
+    std::set<std::vector<EdgeId>> found_routes{routes.front().edges};
 
-    return RouteInfo{weight, std::move(edges)};
+    using Candidate = std::pair<Weight, VertexId>;
+    std::vector<Candidate> candidates;
+    for (VertexId vertex_via = 0; vertex_via < routes_from.size(); ++vertex_via) {
+        const auto& route_to_via = routes_from[vertex_via];
+        const auto& route_from_via = routes_internal_data_[vertex_via][to];
+        if (route_to_via && route_from_via) {
+            candidates.push_back({route_to_via->weight + route_from_via->weight, vertex_via});
+        }
+    }
+    // Кандидаты извлекаются по возрастанию веса, пока не наберётся count маршрутов
+    std::make_heap(candidates.begin(), candidates.end(), std::greater<Candidate>{});
+
+    std::vector<bool> is_visited(graph_.GetVertexCount(), false);
+    while (!candidates.empty() && routes.size() < count) {
+        std::pop_heap(candidates.begin(), candidates.end(), std::greater<Candidate>{});
+        const auto [weight, vertex_via] = candidates.back();
+        candidates.pop_back();
+
+        std::vector<EdgeId> edges = CollectRouteEdges(from, vertex_via);
+        const std::vector<EdgeId> edges_from_via = CollectRouteEdges(vertex_via, to);
+        edges.insert(edges.end(), edges_from_via.begin(), edges_from_via.end());
+        if (!IsLoopFree(from, edges, is_visited) || (is_acceptable && !is_acceptable(edges))
+            || !found_routes.insert(edges).second) {
+            continue;
+        }
+        routes.push_back({weight, std::move(edges)});
+    }
+    return routes;
 }
 
 }  // namespace graph
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "graph.h"
+#include "monotone_queue.h"
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace graph {
+
+// Рабочая память одного поиска кратчайшего пути, переиспользуемая между запросами.
+// Запись вершины действительна, только если её поколение совпадает с поколением текущего поиска, поэтому
+// Reset не очищает массив, а увеличивает счётчик поколений, и запрос тратит время лишь на вершины, которых коснулся.
+// Память очереди тоже остаётся от прошлых запросов
+template <typename Weight, typename QueueValue>
+class SearchWorkspace {
+public:
+    static constexpr Weight UNREACHABLE = std::numeric_limits<Weight>::max();
+
+    struct Entry {
+        Weight distance;
+        // Нижняя оценка расстояния до цели; UNREACHABLE, пока не посчитана
+        Weight bound;
+        EdgeId prev_edge;
+        // Поиск, в котором запись последний раз заполнялась
+        uint32_t generation;
+        bool is_pruned;
+    };
+
+    using Queue = MonotoneQueue<Weight, QueueValue>;
+
+    // Начинает поиск на графе из vertex_count вершин. Массив растёт лишь при первом поиске на большем графе
+    void Reset(size_t vertex_count) {
+        if (++generation_ == 0) {
+            for (Entry& entry : entries_) {
+                entry.generation = 0;
+            }
+            generation_ = 1;
+        }
+        if (entries_.size() < vertex_count) {
+            entries_.resize(vertex_count, Entry{UNREACHABLE, UNREACHABLE, 0, 0, false});
+        }
+        queue_.Clear();
+    }
+
+    // Запись вершины в текущем поиске; при первом обращении она заполняется значениями по умолчанию
+    Entry& Get(VertexId vertex) {
+        Entry& entry = entries_[vertex];
+        if (entry.generation != generation_) {
+            entry = Entry{UNREACHABLE, UNREACHABLE, 0, generation_, false};
+        }
+        return entry;
+    }
+
+    Queue& GetQueue() {
+        return queue_;
+    }
+
+private:
+    std::vector<Entry> entries_;
+    uint32_t generation_ = 0;
+    Queue queue_;
+};
+
+}  // namespace graph
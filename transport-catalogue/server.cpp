@@ -0,0 +1,450 @@
+#include "server.h"
+
+#include "json_reader.h"
+
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace catalogue
+{
+    namespace
+    {
+        using namespace std::literals;
+
+        // Идентификаторы служебных дескрипторов в событиях epoll
+        const uint64_t LISTEN_ID = std::numeric_limits<uint64_t>::max();
+        const uint64_t WAKE_ID = LISTEN_ID - 1;
+
+        // Пока у соединения столько запросов без отправленного ответа, новые запросы не читаются
+        const uint64_t MAX_PENDING_REQUESTS = 1024;
+        // Строка запроса длиннее этого считается ошибкой клиента
+        const size_t MAX_LINE_LENGTH = 1 << 20;
+
+        const int MAX_EVENTS = 64;
+
+        void PrintSystemError(std::string_view what)
+        {
+            std::cerr << "Error: "sv << what << ": "sv << std::strerror(errno) << std::endl;
+        }
+    } // namespace
+
+    Server::FileDescriptor::FileDescriptor(int fd)
+        : fd_(fd) {}
+
+    Server::FileDescriptor::~FileDescriptor()
+    {
+        Reset(-1);
+    }
+
+    void Server::FileDescriptor::Reset(int fd)
+    {
+        if (fd_ >= 0)
+        {
+            close(fd_);
+        }
+        fd_ = fd;
+    }
+
+    int Server::FileDescriptor::Get() const
+    {
+        return fd_;
+    }
+
+    Server::Server(VersionedCatalogue &catalogue, size_t worker_count)
+        : catalogue_(catalogue),
+          epoll_fd_(epoll_create1(EPOLL_CLOEXEC)),
+          wake_fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+          workers_(worker_count)
+    {
+        if (epoll_fd_.Get() < 0 || wake_fd_.Get() < 0)
+        {
+            PrintSystemError("cannot create event loop"sv);
+            return;
+        }
+
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = WAKE_ID;
+        epoll_ctl(epoll_fd_.Get(), EPOLL_CTL_ADD, wake_fd_.Get(), &event);
+    }
+
+    Server::~Server()
+    {
+        for (const auto &[id, connection] : connections_)
+        {
+            close(connection.fd);
+        }
+    }
+
+    bool Server::Run(const std::string &socket_path)
+    {
+        if (epoll_fd_.Get() < 0 || wake_fd_.Get() < 0)
+        {
+            return false;
+        }
+
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (socket_path.size() >= sizeof(address.sun_path))
+        {
+            std::cerr << "Error: socket path is too long: "sv << socket_path << std::endl;
+            return false;
+        }
+        std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+
+        listen_fd_.Reset(socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0));
+        if (listen_fd_.Get() < 0)
+        {
+            PrintSystemError("cannot create socket"sv);
+            return false;
+        }
+        unlink(socket_path.c_str());
+        if (bind(listen_fd_.Get(), reinterpret_cast<const sockaddr *>(&address), sizeof(address)) < 0 || listen(listen_fd_.Get(), SOMAXCONN) < 0)
+        {
+            PrintSystemError("cannot listen on "s + socket_path);
+            return false;
+        }
+
+        epoll_event listen_event{};
+        listen_event.events = EPOLLIN;
+        listen_event.data.u64 = LISTEN_ID;
+        epoll_ctl(epoll_fd_.Get(), EPOLL_CTL_ADD, listen_fd_.Get(), &listen_event);
+
+        epoll_event events[MAX_EVENTS];
+        while (!is_stopping_)
+        {
+            const int count = epoll_wait(epoll_fd_.Get(), events, MAX_EVENTS, -1);
+            if (count < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                PrintSystemError("epoll_wait failed"sv);
+                break;
+            }
+
+            for (int i = 0; i < count; ++i)
+            {
+                const uint64_t id = events[i].data.u64;
+                if (id == LISTEN_ID)
+                {
+                    Accept();
+                    continue;
+                }
+                if (id == WAKE_ID)
+                {
+                    uint64_t value;
+                    [[maybe_unused]] const auto size = read(wake_fd_.Get(), &value, sizeof(value));
+                    CollectCompletions();
+                    continue;
+                }
+
+                // Соединение могло быть закрыто при обработке предыдущего события
+                const auto it = connections_.find(id);
+                if (it == connections_.end())
+                {
+                    continue;
+                }
+                // Закрытое клиентом чтение не нужно читать снова: EPOLLHUP в этом случае означает только, что
+                // отправка, скорее всего, тоже не удастся, и это выяснит Flush
+                if (!it->second.is_read_closed && (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)))
+                {
+                    Read(id, it->second);
+                }
+                if (connections_.count(id) > 0)
+                {
+                    Flush(id, it->second);
+                }
+            }
+        }
+
+        unlink(socket_path.c_str());
+        return true;
+    }
+
+    void Server::Stop()
+    {
+        is_stopping_ = true;
+        const uint64_t value = 1;
+        [[maybe_unused]] const auto size = write(wake_fd_.Get(), &value, sizeof(value));
+    }
+
+    void Server::Accept()
+    {
+        while (true)
+        {
+            const int fd = accept4(listen_fd_.Get(), nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0)
+            {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                {
+                    PrintSystemError("accept failed"sv);
+                }
+                return;
+            }
+
+            const uint64_t id = next_connection_id_++;
+            Connection &connection = connections_[id];
+            connection.fd = fd;
+
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.u64 = id;
+            epoll_ctl(epoll_fd_.Get(), EPOLL_CTL_ADD, fd, &event);
+        }
+    }
+
+    void Server::Read(uint64_t id, Connection &connection)
+    {
+        char buffer[65536];
+        while (connection.is_reading && !connection.is_read_closed)
+        {
+            const ssize_t size = read(connection.fd, buffer, sizeof(buffer));
+            if (size < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                {
+                    Close(id);
+                }
+                return;
+            }
+            if (size == 0)
+            {
+                connection.is_read_closed = true;
+                break;
+            }
+
+            const size_t checked = connection.input.size();
+            connection.input.append(buffer, size);
+
+            size_t line_begin = 0;
+            for (size_t pos = connection.input.find('\n', checked); pos != std::string::npos; pos = connection.input.find('\n', line_begin))
+            {
+                std::string line = connection.input.substr(line_begin, pos - line_begin);
+                line_begin = pos + 1;
+                if (line.find_first_not_of(" \t\r"sv) != std::string::npos)
+                {
+                    Submit(id, connection, std::move(line));
+                }
+            }
+            connection.input.erase(0, line_begin);
+
+            if (connection.input.size() > MAX_LINE_LENGTH)
+            {
+                std::cerr << "Error: request line is too long, closing connection"sv << std::endl;
+                Close(id);
+                return;
+            }
+            if (connection.next_request - connection.next_response >= MAX_PENDING_REQUESTS)
+            {
+                UpdateEvents(id, connection, false, connection.is_writing);
+            }
+        }
+    }
+
+    void Server::Submit(uint64_t id, Connection &connection, std::string line)
+    {
+        const uint64_t sequence = connection.next_request++;
+        workers_.Submit([this, id, sequence, line = std::move(line)]
+                        {
+                            Completion completion{id, sequence, Answer(line)};
+                            bool was_empty;
+                            {
+                                std::lock_guard lock(completions_mutex_);
+                                was_empty = completions_.empty();
+                                completions_.push_back(std::move(completion));
+                            }
+                            // Цикл забирает все готовые ответы сразу, поэтому будить его нужно только для первого
+                            if (was_empty)
+                            {
+                                const uint64_t value = 1;
+                                [[maybe_unused]] const auto size = write(wake_fd_.Get(), &value, sizeof(value));
+                            } });
+    }
+
+    void Server::CollectCompletions()
+    {
+        std::vector<Completion> completions;
+        {
+            std::lock_guard lock(completions_mutex_);
+            completions.swap(completions_);
+        }
+
+        std::vector<uint64_t> touched;
+        for (auto &[id, sequence, response] : completions)
+        {
+            const auto it = connections_.find(id);
+            if (it == connections_.end())
+            {
+                continue;
+            }
+            Connection &connection = it->second;
+            connection.ready.emplace(sequence, std::move(response));
+            touched.push_back(id);
+        }
+
+        for (const uint64_t id : touched)
+        {
+            const auto it = connections_.find(id);
+            if (it == connections_.end())
+            {
+                continue;
+            }
+            Connection &connection = it->second;
+            for (auto ready = connection.ready.begin(); ready != connection.ready.end() && ready->first == connection.next_response; ready = connection.ready.erase(ready))
+            {
+                connection.output += ready->second;
+                connection.output.push_back('\n');
+                ++connection.next_response;
+            }
+            Flush(id, connection);
+        }
+    }
+
+    void Server::Flush(uint64_t id, Connection &connection)
+    {
+        size_t written = 0;
+        while (written < connection.output.size())
+        {
+            const ssize_t size = send(connection.fd, connection.output.data() + written, connection.output.size() - written, MSG_NOSIGNAL);
+            if (size < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                {
+                    Close(id);
+                    return;
+                }
+                break;
+            }
+            written += size;
+        }
+        connection.output.erase(0, written);
+
+        const bool has_pending = connection.next_response != connection.next_request;
+        if (connection.is_read_closed && !has_pending && connection.output.empty())
+        {
+            Close(id);
+            return;
+        }
+
+        const bool is_reading = !connection.is_read_closed && connection.next_request - connection.next_response < MAX_PENDING_REQUESTS;
+        const bool was_reading = connection.is_reading;
+        UpdateEvents(id, connection, is_reading, !connection.output.empty());
+        if (is_reading && !was_reading)
+        {
+            // Пока чтение было приостановлено, в сокете могли накопиться данные
+            Read(id, connection);
+        }
+    }
+
+    void Server::UpdateEvents(uint64_t id, Connection &connection, bool is_reading, bool is_writing)
+    {
+        if (connection.is_reading == is_reading && connection.is_writing == is_writing)
+        {
+            return;
+        }
+        connection.is_reading = is_reading;
+        connection.is_writing = is_writing;
+
+        epoll_event event{};
+        event.events = (is_reading ? uint32_t{EPOLLIN} : 0) | (is_writing ? uint32_t{EPOLLOUT} : 0);
+        event.data.u64 = id;
+        // После закрытия чтения клиентом EPOLLHUP приходит при любой маске, и цикл крутился бы, пока ответы
+        // не готовы. Поэтому такое соединение снимается с epoll, пока ему нечего отправлять; ответы отправит
+        // CollectCompletions, а если сокет заполнится — соединение вернётся в epoll с EPOLLOUT
+        if (connection.is_read_closed && event.events == 0)
+        {
+            epoll_ctl(epoll_fd_.Get(), EPOLL_CTL_DEL, connection.fd, nullptr);
+            connection.is_registered = false;
+        }
+        else
+        {
+            epoll_ctl(epoll_fd_.Get(), connection.is_registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, connection.fd, &event);
+            connection.is_registered = true;
+        }
+    }
+
+    void Server::Close(uint64_t id)
+    {
+        const auto it = connections_.find(id);
+        if (it == connections_.end())
+        {
+            return;
+        }
+        // Ответы на ещё выполняющиеся запросы этого соединения будут отброшены
+        if (it->second.is_registered)
+        {
+            epoll_ctl(epoll_fd_.Get(), EPOLL_CTL_DEL, it->second.fd, nullptr);
+        }
+        close(it->second.fd);
+        connections_.erase(it);
+    }
+
+    std::string Server::Answer(const std::string &line)
+    {
+        std::ostringstream out;
+        // Номер запроса разбирается первым, чтобы вернуть его и в ответе об ошибке
+        std::optional<int> request_id;
+        try
+        {
+            std::istringstream input(line);
+            const json::Document document = json::Load(input);
+            if (!document.GetRoot().IsMap())
+            {
+                throw json::RequestError("bad request");
+            }
+            const auto &request = document.GetRoot().AsMap();
+            if (const auto it = request.find("id"); it != request.end() && it->second.IsInt())
+            {
+                request_id = it->second.AsInt();
+            }
+            const auto type = request.find("type");
+            if (type != request.end() && type->second.IsString() && type->second.AsString() == "Update"sv)
+            {
+                const auto base_requests = request.find("base_requests");
+                if (!request_id || base_requests == request.end())
+                {
+                    throw json::RequestError("bad request");
+                }
+                const uint64_t version = catalogue_.Update([&base_requests](TransportCatalogue &catalogue)
+                                                           { json::ParseBaseRequest(base_requests->second, catalogue); });
+                out << "{\"request_id\":"sv << *request_id << ",\"version\":"sv << version << '}';
+            }
+            else
+            {
+                const auto version = catalogue_.Read();
+                json::PrintCompact(json::GetResponse(version.GetHandler(), json::ParseCommandDescription(document.GetRoot())), out);
+            }
+        }
+        catch (const std::exception &e)
+        {
+            out.str({});
+            out << '{';
+            if (request_id)
+            {
+                out << "\"request_id\":"sv << *request_id << ',';
+            }
+            out << "\"error_message\":\""sv << json::GetErrorMessage(e) << "\"}"sv;
+        }
+        return out.str();
+    }
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "thread_pool.h"
+#include "versioned_catalogue.h"
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace catalogue
+{
+    /*
+     * Сервер запросов к готовому справочнику через Unix-сокет.
+     * Клиент присылает запросы из stat_requests по одному JSON-объекту в строке,
+     * сервер отвечает на каждый строкой с тем же ответом, что и в GetOutputDocument.
+     * Запрос {"id": ..., "type": "Update", "base_requests": [...]} применяет изменения к справочнику
+     * и отвечает номером новой версии; запросы, начатые раньше, дорабатывают на прежней версии.
+     * Ответы на запросы одного соединения приходят в порядке запросов.
+     * Соединения обслуживаются циклом epoll, запросы выполняются в пуле потоков
+     */
+    class Server
+    {
+    public:
+        Server(VersionedCatalogue &catalogue, size_t worker_count);
+        ~Server();
+
+        Server(const Server &) = delete;
+        Server &operator=(const Server &) = delete;
+
+        // Обслуживает соединения, пока не будет вызван Stop. Возвращает false, если сокет не удалось открыть
+        bool Run(const std::string &socket_path);
+
+        // Останавливает Run. Можно вызывать из обработчика сигнала
+        void Stop();
+
+    private:
+        // Владеет файловым дескриптором и закрывает его при разрушении
+        class FileDescriptor
+        {
+        public:
+            FileDescriptor() = default;
+            explicit FileDescriptor(int fd);
+            ~FileDescriptor();
+
+            FileDescriptor(const FileDescriptor &) = delete;
+            FileDescriptor &operator=(const FileDescriptor &) = delete;
+
+            void Reset(int fd);
+
+            int Get() const;
+
+        private:
+            int fd_ = -1;
+        };
+
+        struct Connection
+        {
+            int fd = -1;
+            std::string input;
+            std::string output;
+            // Номер следующего запроса и следующего ответа, который нужно отправить
+            uint64_t next_request = 0;
+            uint64_t next_response = 0;
+            // Готовые ответы, которые ждут более ранних
+            std::map<uint64_t, std::string> ready;
+            bool is_read_closed = false;
+            bool is_reading = true;
+            bool is_writing = false;
+            // Стоит ли дескриптор в epoll, см. UpdateEvents
+            bool is_registered = true;
+        };
+
+        struct Completion
+        {
+            uint64_t connection_id;
+            uint64_t sequence;
+            std::string response;
+        };
+
+        void Accept();
+
+        void Read(uint64_t id, Connection &connection);
+
+        void Submit(uint64_t id, Connection &connection, std::string line);
+
+        void CollectCompletions();
+
+        // Отправляет накопленные ответы и закрывает соединение, если оно больше не нужно
+        void Flush(uint64_t id, Connection &connection);
+
+        void UpdateEvents(uint64_t id, Connection &connection, bool is_reading, bool is_writing);
+
+        void Close(uint64_t id);
+
+        std::string Answer(const std::string &line);
+
+        VersionedCatalogue &catalogue_;
+
+        FileDescriptor epoll_fd_;
+        FileDescriptor listen_fd_;
+        // Будит цикл, когда готовы ответы или пора остановиться
+        FileDescriptor wake_fd_;
+        std::atomic<bool> is_stopping_ = false;
+
+        uint64_t next_connection_id_ = 0;
+        std::unordered_map<uint64_t, Connection> connections_;
+
+        std::mutex completions_mutex_;
+        std::vector<Completion> completions_;
+
+        // Объявлен последним, чтобы задачи завершились до разрушения остальных полей
+        ThreadPool workers_;
+    };
+}
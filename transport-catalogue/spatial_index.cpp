@@ -0,0 +1,165 @@
+#include "spatial_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+
+namespace catalogue
+{
+    namespace renderer
+    {
+        SpatialIndex::SpatialIndex(std::vector<const Bus *> buses)
+            : buses_(std::move(buses))
+        {
+            std::sort(buses_.begin(), buses_.end(), [](const Bus *lhs, const Bus *rhs)
+                      { return lhs->bus_name < rhs->bus_name; });
+
+            // На карте рисуются только остановки, через которые проходят маршруты
+            std::unordered_set<const Stop *> bus_stops;
+            int color_index = 0;
+            for (const Bus *bus : buses_)
+            {
+                color_indexes_.push_back(color_index);
+                if (!bus->bus_stops.empty())
+                {
+                    ++color_index;
+                }
+                for (const Stop *stop : bus->bus_stops)
+                {
+                    if (bus_stops.insert(stop).second)
+                    {
+                        stops_.push_back(stop);
+                    }
+                }
+            }
+            std::sort(stops_.begin(), stops_.end(), [](const Stop *lhs, const Stop *rhs)
+                      { return lhs->stop_name < rhs->stop_name; });
+            for (uint32_t bus_id = 0; bus_id < buses_.size(); ++bus_id)
+            {
+                const auto &bus_stops = buses_[bus_id]->bus_stops;
+                // Маршрут из одной остановки виден там же, где она: отрезок вырождается в точку
+                if (bus_stops.size() == 1)
+                {
+                    segments_.push_back({bus_id, bus_stops[0], bus_stops[0]});
+                }
+                for (size_t i = 1; i < bus_stops.size(); ++i)
+                {
+                    segments_.push_back({bus_id, bus_stops[i - 1], bus_stops[i]});
+                }
+            }
+
+            if (stops_.empty())
+            {
+                return;
+            }
+
+            const auto [left_it, right_it] = std::minmax_element(stops_.begin(), stops_.end(), [](const Stop *lhs, const Stop *rhs)
+                                                                 { return lhs->coords.lng < rhs->coords.lng; });
+            const auto [bottom_it, top_it] = std::minmax_element(stops_.begin(), stops_.end(), [](const Stop *lhs, const Stop *rhs)
+                                                                 { return lhs->coords.lat < rhs->coords.lat; });
+            min_ = {(*bottom_it)->coords.lat, (*left_it)->coords.lng};
+
+            // В среднем на ячейку приходится несколько объектов
+            const size_t side = std::max<size_t>(1, static_cast<size_t>(std::sqrt((stops_.size() + segments_.size()) / 4.0)));
+            rows_ = side;
+            columns_ = side;
+            cell_lat_ = std::max(((*top_it)->coords.lat - min_.lat) / rows_, 1e-9);
+            cell_lng_ = std::max(((*right_it)->coords.lng - min_.lng) / columns_, 1e-9);
+            cells_.resize(rows_ * columns_);
+
+            for (uint32_t id = 0; id < stops_.size(); ++id)
+            {
+                const auto &coords = stops_[id]->coords;
+                GetCell(GetRow(coords.lat), GetColumn(coords.lng)).stop_ids.push_back(id);
+            }
+
+            // Отрезок попадает во все ячейки своего описывающего прямоугольника
+            for (uint32_t id = 0; id < segments_.size(); ++id)
+            {
+                const auto &from = segments_[id].from->coords;
+                const auto &to = segments_[id].to->coords;
+                const size_t from_row = GetRow(from.lat);
+                const size_t to_row = GetRow(to.lat);
+                const size_t from_column = GetColumn(from.lng);
+                const size_t to_column = GetColumn(to.lng);
+                for (size_t row = std::min(from_row, to_row); row <= std::max(from_row, to_row); ++row)
+                {
+                    for (size_t column = std::min(from_column, to_column); column <= std::max(from_column, to_column); ++column)
+                    {
+                        GetCell(row, column).segment_ids.push_back(id);
+                    }
+                }
+            }
+        }
+
+        SpatialIndex::VisibleObjects SpatialIndex::Query(const geo::BoundingBox &viewport) const
+        {
+            VisibleObjects result;
+            if (cells_.empty())
+            {
+                return result;
+            }
+
+            std::vector<uint32_t> stop_ids;
+            std::vector<uint32_t> bus_ids;
+            const size_t row_begin = GetRow(viewport.min.lat);
+            const size_t row_end = GetRow(viewport.max.lat);
+            const size_t column_begin = GetColumn(viewport.min.lng);
+            const size_t column_end = GetColumn(viewport.max.lng);
+            for (size_t row = row_begin; row <= row_end; ++row)
+            {
+                for (size_t column = column_begin; column <= column_end; ++column)
+                {
+                    const Cell &cell = cells_[row * columns_ + column];
+                    for (const uint32_t id : cell.stop_ids)
+                    {
+                        if (viewport.Contains(stops_[id]->coords))
+                        {
+                            stop_ids.push_back(id);
+                        }
+                    }
+                    for (const uint32_t id : cell.segment_ids)
+                    {
+                        const Segment &segment = segments_[id];
+                        if (viewport.Intersects(segment.from->coords, segment.to->coords))
+                        {
+                            bus_ids.push_back(segment.bus_id);
+                        }
+                    }
+                }
+            }
+
+            // Номера присвоены в порядке названий, поэтому сортировка по номеру восстанавливает порядок карты
+            std::sort(stop_ids.begin(), stop_ids.end());
+            std::sort(bus_ids.begin(), bus_ids.end());
+            bus_ids.erase(std::unique(bus_ids.begin(), bus_ids.end()), bus_ids.end());
+
+            for (const uint32_t id : stop_ids)
+            {
+                result.stops.push_back(stops_[id]);
+            }
+            for (const uint32_t id : bus_ids)
+            {
+                result.buses.push_back({buses_[id], color_indexes_[id]});
+            }
+            return result;
+        }
+
+        size_t SpatialIndex::GetColumn(double lng) const
+        {
+            const double column = std::floor((lng - min_.lng) / cell_lng_);
+            return static_cast<size_t>(std::clamp(column, 0.0, static_cast<double>(columns_ - 1)));
+        }
+
+        size_t SpatialIndex::GetRow(double lat) const
+        {
+            const double row = std::floor((lat - min_.lat) / cell_lat_);
+            return static_cast<size_t>(std::clamp(row, 0.0, static_cast<double>(rows_ - 1)));
+        }
+
+        SpatialIndex::Cell &SpatialIndex::GetCell(size_t row, size_t column)
+        {
+            return cells_[row * columns_ + column];
+        }
+    } // namespace renderer
+} // namespace catalogue
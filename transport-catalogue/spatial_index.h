@@ -0,0 +1,70 @@
+#pragma once
+
+#include "domain.h"
+#include "geo.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace catalogue
+{
+    namespace renderer
+    {
+        /*
+         * Равномерная сетка над остановками и отрезками маршрутов.
+         * Позволяет найти объекты, попадающие в область карты, просматривая только ячейки этой области
+         */
+        class SpatialIndex
+        {
+        public:
+            struct VisibleBus
+            {
+                const Bus *bus;
+                // Номер цвета маршрута в палитре, такой же, как на полной карте
+                int color_index;
+            };
+
+            // Результат запроса упорядочен по названиям, как и на полной карте
+            struct VisibleObjects
+            {
+                std::vector<VisibleBus> buses;
+                std::vector<const Stop *> stops;
+            };
+
+            explicit SpatialIndex(std::vector<const Bus *> buses);
+
+            VisibleObjects Query(const geo::BoundingBox &viewport) const;
+
+        private:
+            struct Segment
+            {
+                uint32_t bus_id;
+                const Stop *from;
+                const Stop *to;
+            };
+
+            struct Cell
+            {
+                std::vector<uint32_t> stop_ids;
+                std::vector<uint32_t> segment_ids;
+            };
+
+            size_t GetColumn(double lng) const;
+            size_t GetRow(double lat) const;
+            Cell &GetCell(size_t row, size_t column);
+
+            // Остановки и маршруты пронумерованы в порядке названий
+            std::vector<const Stop *> stops_;
+            std::vector<const Bus *> buses_;
+            std::vector<int> color_indexes_;
+            std::vector<Segment> segments_;
+
+            geo::Coordinates min_;
+            double cell_lat_ = 1.0;
+            double cell_lng_ = 1.0;
+            size_t rows_ = 1;
+            size_t columns_ = 1;
+            std::vector<Cell> cells_;
+        };
+    } // namespace renderer
+} // namespace catalogue
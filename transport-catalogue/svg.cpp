@@ -1,7 +1,5 @@
 #include "svg.h"
 
-#include <unordered_map>
-
 namespace svg
 {
     using namespace std::literals;
@@ -62,6 +60,104 @@ namespace svg
         return out;
     }
 
+    void PathStyle::Render(std::ostream &out) const
+    {
+        if (fill_color)
+        {
+            out << " fill=\""sv;
+            std::visit(RenderColor{out}, *fill_color);
+            out << "\""sv;
+        }
+        if (stroke_color)
+        {
+            out << " stroke=\""sv;
+            std::visit(RenderColor{out}, *stroke_color);
+            out << "\""sv;
+        }
+        if (width)
+        {
+            out << " stroke-width=\""sv << *width << "\""sv;
+        }
+        if (line_cap)
+        {
+            out << " stroke-linecap=\""sv;
+            out << (*line_cap);
+            out << "\""sv;
+        }
+        if (line_join)
+        {
+            out << " stroke-linejoin=\""sv;
+            out << (*line_join);
+            out << "\""sv;
+        }
+    }
+
+    namespace
+    {
+        void RenderData(std::ostream &out, std::string_view data)
+        {
+            for (const char c : data)
+            {
+                switch (c)
+                {
+                case '"':
+                    out << "&quot;"sv;
+                    break;
+                case '<':
+                    out << "&lt;"sv;
+                    break;
+                case '>':
+                    out << "&gt;"sv;
+                    break;
+                case '\'':
+                    out << "&apos;"sv;
+                    break;
+                case '&':
+                    out << "&amp;"sv;
+                    break;
+                default:
+                    out.put(c);
+                }
+            }
+        }
+
+        void RenderCircle(std::ostream &out, Point center, double radius, const PathStyle &style)
+        {
+            out << "<circle cx=\""sv << center.x << "\" cy=\""sv << center.y << "\" "sv;
+            out << "r=\""sv << radius << "\""sv;
+            style.Render(out);
+            out << "/>"sv;
+        }
+
+        void RenderPolylineEnd(std::ostream &out, const PathStyle &style)
+        {
+            out << "\" "sv;
+            style.Render(out);
+            out << "/>"sv;
+        }
+
+        void RenderText(std::ostream &out, Point pos, const TextStyle &text_style, const PathStyle &style, std::string_view data)
+        {
+            out << "<text x=\""sv << pos.x << "\" y=\""sv << pos.y << "\" dx=\""sv;
+            out << text_style.offset.x << "\" dy=\""sv << text_style.offset.y << "\" font-size=\""sv << text_style.size;
+            out << "\""sv;
+            if (!text_style.font_family.empty())
+            {
+                out << " font-family=\""sv << text_style.font_family << "\""sv;
+            }
+
+            if (!text_style.font_weight.empty())
+            {
+                out << " font-weight=\""sv << text_style.font_weight << "\""sv;
+            }
+            style.Render(out);
+            out << ">"sv;
+
+            RenderData(out, data);
+            out << "</text>"sv;
+        }
+    } // namespace
+
     void Object::Render(const RenderContext &context) const
     {
         context.RenderIndent();
@@ -107,11 +203,7 @@ namespace svg
 
     void Circle::RenderObject(const RenderContext &context) const
     {
-        auto &out = context.out;
-        out << "<circle cx=\""sv << center_.x << "\" cy=\""sv << center_.y << "\" "sv;
-        out << "r=\""sv << radius_ << "\""sv;
-        RenderOptionalAttrs(context.out);
-        out << "/>"sv;
+        RenderCircle(context.out, center_, radius_, GetStyle());
     }
 
     // ---------- Polyline ------------------
@@ -136,9 +228,7 @@ namespace svg
                 out << " "sv;
             }
         }
-        out << "\" ";
-        RenderOptionalAttrs(context.out);
-        out << "/>"sv;
+        RenderPolylineEnd(out, GetStyle());
     }
 
     // ---------- Text ------------------
@@ -179,43 +269,374 @@ namespace svg
         return *this;
     }
 
-    void RenderData(std::ostream &out, std::string_view data)
+    void Text::RenderObject(const RenderContext &context) const
     {
-        const std::unordered_map<char, std::string_view> speshial_chars = {{'"', "&quot;"sv}, {'<', "&lt;"}, {'>', "&gt;"}, {'\'', "&apos;"}, {'&', "&amp;"}};
-        for (const auto &c : data)
+        RenderText(context.out, pos_, {offset_, size_, font_family_, font_weight_}, GetStyle(), data_);
+    }
+
+    // ---------- StreamWriter ------------------
+
+    namespace
+    {
+        void RenderCss(std::ostream &out, const PathStyle &style, const TextStyle *text_style)
         {
-            const auto it = speshial_chars.find(c);
-            if (it != speshial_chars.end())
+            if (style.fill_color)
+            {
+                out << "fill:"sv << *style.fill_color << ';';
+            }
+            if (style.stroke_color)
             {
-                out << it->second;
+                out << "stroke:"sv << *style.stroke_color << ';';
             }
-            else
+            if (style.width)
             {
-                out << c;
+                out << "stroke-width:"sv << *style.width << "px;"sv;
+            }
+            if (style.line_cap)
+            {
+                out << "stroke-linecap:"sv << *style.line_cap << ';';
+            }
+            if (style.line_join)
+            {
+                out << "stroke-linejoin:"sv << *style.line_join << ';';
+            }
+            if (text_style)
+            {
+                out << "font-size:"sv << text_style->size << "px;"sv;
+                if (!text_style->font_family.empty())
+                {
+                    out << "font-family:"sv << text_style->font_family << ';';
+                }
+                if (!text_style->font_weight.empty())
+                {
+                    out << "font-weight:"sv << text_style->font_weight << ';';
+                }
             }
         }
+    } // namespace
+
+    StreamWriter::StreamWriter(std::ostream &out)
+        : context_(out, 2, 2)
+    {
     }
 
-    void Text::RenderObject(const RenderContext &context) const
+    StreamWriter::StreamWriter(std::ostream &out, CompactFormat format)
+        : context_(out), compact_(format)
     {
-        auto &out = context.out;
-        out << "<text x=\""sv << pos_.x << "\" y=\"" << pos_.y << "\" dx=\"";
-        out << offset_.x << "\" dy=\"" << offset_.y << "\" font-size=\"" << size_;
-        out << "\"";
-        if (!font_family_.empty())
+        // Координаты хранятся в int64_t, поэтому точность ограничена девятью знаками
+        for (int i = 0; i < format.precision && i < 9; ++i)
+        {
+            units_per_pixel_ *= 10;
+        }
+    }
+
+    StreamWriter StreamWriter::MakeFragmentWriter(std::ostream &out) const
+    {
+        StreamWriter writer = compact_ ? StreamWriter(out, *compact_) : StreamWriter(out);
+        writer.classes_ = classes_;
+        return writer;
+    }
+
+    void StreamWriter::DefineClass(const PathStyle &style, const TextStyle *text_style)
+    {
+        if (compact_ && FindClass(style, text_style) < 0)
+        {
+            classes_.push_back({&style, text_style, nullptr});
+        }
+    }
+
+    void StreamWriter::DefineLabelClass(const PathStyle &underlayer, const PathStyle &style, const TextStyle &text_style)
+    {
+        if (compact_ && FindClass(style, &text_style, &underlayer) < 0)
+        {
+            classes_.push_back({&style, &text_style, &underlayer});
+        }
+    }
+
+    void StreamWriter::Begin()
+    {
+        auto &out = context_.out;
+        out << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>"sv;
+        EndElement();
+        out << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">"sv;
+        EndElement();
+
+        if (compact_ && !classes_.empty())
+        {
+            out << "<style>"sv;
+            for (size_t i = 0; i < classes_.size(); ++i)
+            {
+                const StyleClass &style_class = classes_[i];
+                out << ".c"sv << i << '{';
+                if (style_class.underlayer)
+                {
+                    PathStyle label_style = *style_class.underlayer;
+                    label_style.fill_color = style_class.style->fill_color;
+                    RenderCss(out, label_style, style_class.text_style);
+                    out << "paint-order:stroke;"sv;
+                }
+                else
+                {
+                    RenderCss(out, *style_class.style, style_class.text_style);
+                }
+                out << '}';
+            }
+            out << "</style>"sv;
+        }
+    }
+
+    void StreamWriter::End()
+    {
+        context_.out << "</svg>"sv;
+    }
+
+    void StreamWriter::WriteCircle(Point center, double radius, const PathStyle &style)
+    {
+        auto &out = context_.out;
+        if (!compact_)
+        {
+            context_.RenderIndent();
+            RenderCircle(out, center, radius, style);
+            EndElement();
+            return;
+        }
+
+        out << "<circle cx=\""sv;
+        WriteNumber(center.x);
+        out << "\" cy=\""sv;
+        WriteNumber(center.y);
+        out << "\" r=\""sv;
+        WriteNumber(radius);
+        out << '"';
+        if (const int class_index = FindClass(style, nullptr); class_index >= 0)
+        {
+            WriteClass(class_index);
+        }
+        else
         {
-            out << " font-family=\"" << font_family_ << "\"";
+            style.Render(out);
         }
+        out << "/>"sv;
+    }
+
+    void StreamWriter::BeginPolyline()
+    {
+        context_.RenderIndent();
+        context_.out << (compact_ ? "<path d=\""sv : "<polyline points=\""sv);
+        is_first_point_ = true;
+    }
 
-        if (!font_weight_.empty())
+    void StreamWriter::AddPolylinePoint(Point point)
+    {
+        auto &out = context_.out;
+        if (!compact_)
         {
-            out << " font-weight=\"" << font_weight_ << "\"";
+            if (!is_first_point_)
+            {
+                out.put(' ');
+            }
+            out << point.x << ","sv << point.y;
+            is_first_point_ = false;
+            return;
         }
-        RenderOptionalAttrs(context.out);
-        out << ">";
 
-        RenderData(out, data_);
-        out << "</text>";
+        // Смещения считаются между уже округлёнными точками, поэтому ошибка округления не накапливается
+        const int64_t x = ToUnits(point.x);
+        const int64_t y = ToUnits(point.y);
+        if (is_first_point_)
+        {
+            out.put('M');
+            WriteUnits(x);
+            if (y >= 0)
+            {
+                out.put(' ');
+            }
+            WriteUnits(y);
+            is_first_point_ = false;
+            is_line_started_ = false;
+        }
+        else if (x != last_x_ || y != last_y_)
+        {
+            // Знак минуса сам отделяет числа друг от друга
+            const int64_t dx = x - last_x_;
+            const int64_t dy = y - last_y_;
+            // Команда l пишется перед первым смещением: ломаная из одной точки остаётся просто «M x y»
+            if (!is_line_started_)
+            {
+                out.put('l');
+                is_line_started_ = true;
+            }
+            else if (dx >= 0)
+            {
+                out.put(' ');
+            }
+            WriteUnits(dx);
+            if (dy >= 0)
+            {
+                out.put(' ');
+            }
+            WriteUnits(dy);
+        }
+        last_x_ = x;
+        last_y_ = y;
+    }
+
+    void StreamWriter::EndPolyline(const PathStyle &style)
+    {
+        if (!compact_)
+        {
+            RenderPolylineEnd(context_.out, style);
+            EndElement();
+            return;
+        }
+
+        context_.out << '"';
+        if (const int class_index = FindClass(style, nullptr); class_index >= 0)
+        {
+            WriteClass(class_index);
+        }
+        else
+        {
+            style.Render(context_.out);
+        }
+        context_.out << "/>"sv;
+    }
+
+    void StreamWriter::WriteText(Point pos, const TextStyle &text_style, const PathStyle &style, std::string_view data)
+    {
+        auto &out = context_.out;
+        if (!compact_)
+        {
+            context_.RenderIndent();
+            RenderText(out, pos, text_style, style, data);
+            EndElement();
+            return;
+        }
+
+        // Смещение надписи переносится в её координаты, чтобы не выводить dx и dy
+        out << "<text x=\""sv;
+        WriteNumber(pos.x + text_style.offset.x);
+        out << "\" y=\""sv;
+        WriteNumber(pos.y + text_style.offset.y);
+        out << '"';
+        if (const int class_index = FindClass(style, &text_style); class_index >= 0)
+        {
+            WriteClass(class_index);
+        }
+        else
+        {
+            out << " font-size=\""sv << text_style.size << '"';
+            if (!text_style.font_family.empty())
+            {
+                out << " font-family=\""sv << text_style.font_family << '"';
+            }
+            if (!text_style.font_weight.empty())
+            {
+                out << " font-weight=\""sv << text_style.font_weight << '"';
+            }
+            style.Render(out);
+        }
+        out << '>';
+        RenderData(out, data);
+        out << "</text>"sv;
+    }
+
+    void StreamWriter::WriteLabel(Point pos, const TextStyle &text_style, const PathStyle &underlayer, const PathStyle &style, std::string_view data)
+    {
+        const int class_index = compact_ ? FindClass(style, &text_style, &underlayer) : -1;
+        if (class_index < 0)
+        {
+            WriteText(pos, text_style, underlayer, data);
+            WriteText(pos, text_style, style, data);
+            return;
+        }
+
+        auto &out = context_.out;
+        out << "<text x=\""sv;
+        WriteNumber(pos.x + text_style.offset.x);
+        out << "\" y=\""sv;
+        WriteNumber(pos.y + text_style.offset.y);
+        out << '"';
+        WriteClass(class_index);
+        out << '>';
+        RenderData(out, data);
+        out << "</text>"sv;
+    }
+
+    void StreamWriter::WriteRaw(std::string_view fragment)
+    {
+        context_.out << fragment;
+    }
+
+    int StreamWriter::FindClass(const PathStyle &style, const TextStyle *text_style, const PathStyle *underlayer) const
+    {
+        for (size_t i = 0; i < classes_.size(); ++i)
+        {
+            if (classes_[i].style == &style && classes_[i].text_style == text_style && classes_[i].underlayer == underlayer)
+            {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    int64_t StreamWriter::ToUnits(double value) const
+    {
+        return std::llround(value * units_per_pixel_);
+    }
+
+    void StreamWriter::WriteUnits(int64_t units)
+    {
+        auto &out = context_.out;
+        if (units < 0)
+        {
+            out.put('-');
+            units = -units;
+        }
+
+        const int64_t integer_part = units / units_per_pixel_;
+        int64_t fraction = units % units_per_pixel_;
+        // Ноль перед точкой не нужен: ".5" — корректное число в SVG
+        if (integer_part != 0 || fraction == 0)
+        {
+            out << integer_part;
+        }
+        if (fraction == 0)
+        {
+            return;
+        }
+
+        char digits[20];
+        int digit_count = 0;
+        for (int64_t scale = units_per_pixel_ / 10; scale > 0; scale /= 10)
+        {
+            digits[digit_count++] = static_cast<char>('0' + fraction / scale);
+            fraction %= scale;
+        }
+        while (digits[digit_count - 1] == '0')
+        {
+            --digit_count;
+        }
+        out.put('.');
+        out.write(digits, digit_count);
+    }
+
+    void StreamWriter::WriteNumber(double value)
+    {
+        WriteUnits(ToUnits(value));
+    }
+
+    void StreamWriter::WriteClass(int class_index)
+    {
+        context_.out << " class=\"c"sv << class_index << '"';
+    }
+
+    void StreamWriter::EndElement()
+    {
+        if (!compact_)
+        {
+            context_.out.put('\n');
+        }
     }
 
 } // namespace svg
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 
@@ -181,75 +182,72 @@ namespace svg
 
     std::ostream &operator<<(std::ostream &out, StrokeLineJoin line_join);
 
+    /*
+     * Набор атрибутов заливки и обводки элемента.
+     * Один набор можно применять к множеству элементов, не копируя цвета в каждый из них
+     */
+    struct PathStyle
+    {
+        std::optional<Color> fill_color;
+        std::optional<Color> stroke_color;
+        std::optional<double> width;
+        std::optional<StrokeLineCap> line_cap;
+        std::optional<StrokeLineJoin> line_join;
+
+        void Render(std::ostream &out) const;
+    };
+
+    /*
+     * Атрибуты текста, общие для всех надписей одного вида
+     */
+    struct TextStyle
+    {
+        Point offset;
+        uint32_t size = 1;
+        std::string_view font_family;
+        std::string_view font_weight;
+    };
+
     template <typename Owner>
     class PathProps
     {
     public:
         Owner &SetFillColor(Color color)
         {
-            fill_color_ = std::move(color);
+            style_.fill_color = std::move(color);
             return AsOwner();
         }
 
         Owner &SetStrokeColor(Color color)
         {
-            stroke_color_ = std::move(color);
+            style_.stroke_color = std::move(color);
             return AsOwner();
         }
 
         Owner &SetStrokeWidth(double width)
         {
-            width_ = width;
+            style_.width = width;
             return AsOwner();
         }
 
         Owner &SetStrokeLineCap(StrokeLineCap line_cap)
         {
-            line_cap_ = line_cap;
+            style_.line_cap = line_cap;
             return AsOwner();
         }
 
         Owner &SetStrokeLineJoin(StrokeLineJoin line_join)
         {
-            line_join_ = line_join;
+            style_.line_join = line_join;
             return AsOwner();
         }
 
     protected:
         ~PathProps() = default;
 
-        void RenderOptionalAttrs(std::ostream &out) const
+        const PathStyle &GetStyle() const
         {
-            using namespace std::literals;
-
-            if (fill_color_)
-            {
-                out << " fill=\""sv;
-                std::visit(RenderColor{out}, *fill_color_);
-                out << "\""sv;
-            }
-            if (stroke_color_)
-            {
-                out << " stroke=\""sv;
-                std::visit(RenderColor{out}, *stroke_color_);
-                out << "\""sv;
-            }
-            if (width_)
-            {
-                out << " stroke-width=\""sv << *width_ << "\""sv;
-            }
-            if (line_cap_)
-            {
-                out << " stroke-linecap=\""sv;
-                out << (*line_cap_);
-                out << "\""sv;
-            }
-            if (line_join_)
-            {
-                out << " stroke-linejoin=\""sv;
-                out << (*line_join_);
-                out << "\""sv;
-            }
+            return style_;
         }
 
     private:
@@ -260,11 +258,7 @@ namespace svg
             return static_cast<Owner &>(*this);
         }
 
-        std::optional<Color> fill_color_;
-        std::optional<Color> stroke_color_;
-        std::optional<double> width_;
-        std::optional<StrokeLineCap> line_cap_;
-        std::optional<StrokeLineJoin> line_join_;
+        PathStyle style_;
     };
 
     /*
@@ -341,4 +335,91 @@ namespace svg
         std::string data_;
     };
 
+    /*
+     * Параметры компактного вывода: наборы атрибутов выносятся в CSS-классы блока <style>,
+     * ломаные выводятся как <path> с относительными координатами, отступы и переводы строк опускаются
+     */
+    struct CompactFormat
+    {
+        // Число знаков после запятой в координатах и размерах
+        int precision = 2;
+    };
+
+    /*
+     * Класс StreamWriter выводит элементы SVG-документа сразу в поток, не создавая объектов.
+     * В обычном режиме результат совпадает с выводом Document::Render для той же последовательности элементов
+     */
+    class StreamWriter
+    {
+    public:
+        explicit StreamWriter(std::ostream &out);
+        StreamWriter(std::ostream &out, CompactFormat format);
+
+        // Создаёт writer для фрагмента этого же документа с тем же режимом вывода и набором классов
+        StreamWriter MakeFragmentWriter(std::ostream &out) const;
+
+        // Регистрирует сочетание атрибутов как CSS-класс. Элементы узнают класс по адресам style и text_style,
+        // поэтому объекты должны жить до конца вывода. Вызывается до Begin, в обычном режиме ни на что не влияет
+        void DefineClass(const PathStyle &style, const TextStyle *text_style = nullptr);
+
+        // Регистрирует класс надписи с подложкой для WriteLabel: заливка из style, обводка из underlayer,
+        // обводка рисуется под заливкой (paint-order), поэтому подложка не требует отдельного элемента
+        void DefineLabelClass(const PathStyle &underlayer, const PathStyle &style, const TextStyle &text_style);
+
+        // Выводит заголовок документа и открывающий тег <svg>
+        void Begin();
+
+        // Выводит закрывающий тег </svg>
+        void End();
+
+        void WriteCircle(Point center, double radius, const PathStyle &style);
+
+        // Вершины ломаной передаются по одной между BeginPolyline и EndPolyline
+        void BeginPolyline();
+        void AddPolylinePoint(Point point);
+        void EndPolyline(const PathStyle &style);
+
+        void WriteText(Point pos, const TextStyle &text_style, const PathStyle &style, std::string_view data);
+
+        // Надпись с подложкой: в обычном режиме два элемента <text>, в компактном — один, если класс надписи
+        // зарегистрирован через DefineLabelClass
+        void WriteLabel(Point pos, const TextStyle &text_style, const PathStyle &underlayer, const PathStyle &style, std::string_view data);
+
+        // Вставляет готовый фрагмент документа, выведенный другим StreamWriter
+        void WriteRaw(std::string_view fragment);
+
+    private:
+        struct StyleClass
+        {
+            const PathStyle *style;
+            const TextStyle *text_style;
+            // Подложка классов надписей из DefineLabelClass
+            const PathStyle *underlayer;
+        };
+
+        // Номер класса для сочетания атрибутов, -1 — если класс не зарегистрирован
+        int FindClass(const PathStyle &style, const TextStyle *text_style, const PathStyle *underlayer = nullptr) const;
+
+        // Переводит значение в целое число единиц последнего выводимого разряда
+        int64_t ToUnits(double value) const;
+
+        void WriteUnits(int64_t units);
+
+        void WriteNumber(double value);
+
+        void WriteClass(int class_index);
+
+        void EndElement();
+
+        RenderContext context_;
+        std::optional<CompactFormat> compact_;
+        int64_t units_per_pixel_ = 1;
+        std::vector<StyleClass> classes_;
+        bool is_first_point_ = true;
+        // Выведена ли уже команда l текущей ломаной
+        bool is_line_started_ = false;
+        int64_t last_x_ = 0;
+        int64_t last_y_ = 0;
+    };
+
 } // namespace svg
\ No newline at end of file
@@ -0,0 +1,57 @@
+#include "thread_pool.h"
+
+namespace catalogue
+{
+    ThreadPool::ThreadPool(size_t thread_count)
+    {
+        if (thread_count == 0)
+        {
+            thread_count = 1;
+        }
+
+        workers_.reserve(thread_count);
+        for (size_t i = 0; i < thread_count; ++i)
+        {
+            workers_.emplace_back([this]
+                                  { Work(); });
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard lock(mutex_);
+            is_stopping_ = true;
+        }
+        has_tasks_.notify_all();
+        for (auto &worker : workers_)
+        {
+            worker.join();
+        }
+    }
+
+    size_t ThreadPool::GetThreadCount() const
+    {
+        return workers_.size();
+    }
+
+    void ThreadPool::Work()
+    {
+        while (true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock lock(mutex_);
+                has_tasks_.wait(lock, [this]
+                                { return is_stopping_ || !tasks_.empty(); });
+                if (tasks_.empty())
+                {
+                    return;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace catalogue
+{
+    /*
+     * Пул потоков фиксированного размера с общей очередью задач.
+     * Задача, выполняемая в пуле, не должна ждать результата другой задачи того же пула
+     */
+    class ThreadPool
+    {
+    public:
+        explicit ThreadPool(size_t thread_count);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        template <typename Func>
+        auto Submit(Func func) -> std::future<decltype(func())>;
+
+        size_t GetThreadCount() const;
+
+    private:
+        void Work();
+
+        std::vector<std::thread> workers_;
+        std::deque<std::function<void()>> tasks_;
+        std::mutex mutex_;
+        std::condition_variable has_tasks_;
+        bool is_stopping_ = false;
+    };
+
+    template <typename Func>
+    auto ThreadPool::Submit(Func func) -> std::future<decltype(func())>
+    {
+        // std::function требует копируемости, поэтому задача хранится через shared_ptr
+        auto task = std::make_shared<std::packaged_task<decltype(func())()>>(std::move(func));
+        auto result = task->get_future();
+        {
+            std::lock_guard lock(mutex_);
+            tasks_.push_back([task]
+                             { (*task)(); });
+        }
+        has_tasks_.notify_one();
+        return result;
+    }
+}
@@ -0,0 +1,96 @@
+// Клиент для проверки режима сервера: отправляет строки из stdin в Unix-сокет и печатает ответы.
+// Сборка: g++ -std=c++17 -O2 -pthread client.cpp -o client
+// Запуск: ./client /tmp/catalogue.sock < requests.ndjson
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std::literals;
+
+namespace
+{
+    bool WriteAll(int fd, std::string_view data)
+    {
+        while (!data.empty())
+        {
+            const ssize_t size = send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+            if (size < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return false;
+            }
+            data.remove_prefix(size);
+        }
+        return true;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 2)
+    {
+        std::cerr << "Usage: "sv << argv[0] << " SOCKET_PATH"sv << std::endl;
+        return 1;
+    }
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    const std::string_view path = argv[1];
+    if (path.size() >= sizeof(address.sun_path))
+    {
+        std::cerr << "Error: socket path is too long"sv << std::endl;
+        return 1;
+    }
+    std::memcpy(address.sun_path, path.data(), path.size());
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) < 0)
+    {
+        std::cerr << "Error: cannot connect to "sv << path << ": "sv << std::strerror(errno) << std::endl;
+        return 1;
+    }
+
+    // Запросы отправляются отдельным потоком, чтобы сервер не упёрся в непрочитанные ответы
+    std::thread sender([fd]
+                       {
+                           std::string line;
+                           while (std::getline(std::cin, line))
+                           {
+                               line.push_back('\n');
+                               if (!WriteAll(fd, line))
+                               {
+                                   break;
+                               }
+                           }
+                           shutdown(fd, SHUT_WR); });
+
+    char buffer[65536];
+    while (true)
+    {
+        const ssize_t size = read(fd, buffer, sizeof(buffer));
+        if (size < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (size <= 0)
+        {
+            break;
+        }
+        std::cout.write(buffer, size);
+    }
+    std::cout.flush();
+
+    sender.join();
+    close(fd);
+}
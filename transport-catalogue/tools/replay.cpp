@@ -0,0 +1,287 @@
+// Воспроизводит журнал запросов через весь конвейер: ParseRequests, RequestHandler и вывод ответа в JSON.
+// Печатает пропускную способность и задержки по видам запросов; с --hgrm сохраняет распределения
+// в формате .hgrm, который понимают инструменты HdrHistogram.
+// Журнал — по одному запросу из stat_requests в строке, как для режима сервера; без журнала
+// воспроизводятся stat_requests из базового документа.
+// Сборка: g++ -std=c++17 -O2 -pthread -I.. replay.cpp ../histogram.cpp ../json.cpp ../json_builder.cpp ../json_reader.cpp
+//         ../transport_catalogue.cpp ../transport_router.cpp ../arena.cpp ../raptor.cpp ../name_index.cpp ../domain.cpp ../geo.cpp
+//         ../map_renderer.cpp ../svg.cpp ../spatial_index.cpp ../request_handler.cpp ../thread_pool.cpp ../metrics.cpp -o replay
+// Запуск: ./replay base.json [requests.ndjson] [--threads N] [--warmup N] [--repeat N] [--hgrm префикс]
+
+#include "histogram.h"
+#include "json_reader.h"
+#include "map_renderer.h"
+#include "request_handler.h"
+#include "thread_pool.h"
+#include "transport_router.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace catalogue;
+using namespace std::literals;
+
+namespace
+{
+    struct Options
+    {
+        std::string base_path;
+        std::string log_path;
+        size_t threads = 1;
+        // Сколько запросов выполнить до начала замеров, чтобы прогреть кэши
+        size_t warmup = 0;
+        // Сколько раз пройти журнал при замерах
+        size_t repeat = 1;
+        std::string hgrm_prefix;
+    };
+
+    std::optional<Options> ParseOptions(int argc, char *argv[])
+    {
+        Options options;
+        std::vector<std::string> paths;
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string_view arg = argv[i];
+            if (arg.substr(0, 2) != "--"sv)
+            {
+                paths.emplace_back(arg);
+                continue;
+            }
+            if (i + 1 >= argc)
+            {
+                std::cerr << "Missing value for option "sv << arg << std::endl;
+                return std::nullopt;
+            }
+
+            const std::string value = argv[++i];
+            if (arg == "--threads"sv)
+            {
+                options.threads = std::max<size_t>(1, std::stoul(value));
+            }
+            else if (arg == "--warmup"sv)
+            {
+                options.warmup = std::stoul(value);
+            }
+            else if (arg == "--repeat"sv)
+            {
+                options.repeat = std::max<size_t>(1, std::stoul(value));
+            }
+            else if (arg == "--hgrm"sv)
+            {
+                options.hgrm_prefix = value;
+            }
+            else
+            {
+                std::cerr << "Unknown option: "sv << arg << std::endl;
+                return std::nullopt;
+            }
+        }
+
+        if (paths.empty() || paths.size() > 2)
+        {
+            std::cerr << "Usage: replay base.json [requests.ndjson] [--threads N] [--warmup N] [--repeat N] [--hgrm prefix]"sv << std::endl;
+            return std::nullopt;
+        }
+        options.base_path = paths[0];
+        options.log_path = paths.size() > 1 ? paths[1] : "";
+        return options;
+    }
+
+    std::vector<json::StatRequests> LoadLog(const std::string &path)
+    {
+        std::ifstream input(path);
+        if (!input)
+        {
+            throw std::runtime_error("Can't open "s + path);
+        }
+
+        std::vector<json::StatRequests> requests;
+        std::string line;
+        while (std::getline(input, line))
+        {
+            if (line.find_first_not_of(" \t\r"sv) == std::string::npos)
+            {
+                continue;
+            }
+            std::istringstream line_input(line);
+            requests.push_back(json::ParseCommandDescription(json::Load(line_input).GetRoot()));
+        }
+        return requests;
+    }
+
+    // Задержки одного потока по видам запросов, номера видов — как в type_names
+    struct WorkerStats
+    {
+        std::vector<LatencyHistogram> histograms;
+        size_t output_bytes = 0;
+        // Запросы, обработка которых завершилась исключением; в задержки они не попадают
+        size_t failed = 0;
+    };
+
+    void PrintRow(std::string_view type, const LatencyHistogram &histogram, double seconds)
+    {
+        const auto to_microseconds = [](uint64_t nanoseconds)
+        {
+            return nanoseconds / 1000.0;
+        };
+        std::cout << std::left << std::setw(8) << type << std::right << std::setw(10) << histogram.GetCount()
+                  << std::setw(12) << std::setprecision(0) << histogram.GetCount() / seconds << std::setprecision(1)
+                  << std::setw(10) << histogram.GetMean() / 1000.0
+                  << std::setw(10) << to_microseconds(histogram.GetValueAtPercentile(50))
+                  << std::setw(10) << to_microseconds(histogram.GetValueAtPercentile(95))
+                  << std::setw(10) << to_microseconds(histogram.GetValueAtPercentile(99))
+                  << std::setw(10) << to_microseconds(histogram.GetValueAtPercentile(99.9))
+                  << std::setw(12) << to_microseconds(histogram.GetMax()) << '\n';
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const auto options = ParseOptions(argc, argv);
+    if (!options)
+    {
+        return 1;
+    }
+
+    std::ifstream base_input(options->base_path);
+    if (!base_input)
+    {
+        std::cerr << "Can't open "sv << options->base_path << std::endl;
+        return 1;
+    }
+
+    const auto load_start = std::chrono::steady_clock::now();
+    TransportCatalogue catalogue;
+    std::vector<json::StatRequests> requests;
+    renderer::RenderSettings rend_sett;
+    router::RouterSettings rout_sett{};
+    json::ParseRequests(json::Load(base_input), catalogue, requests, rend_sett, rout_sett);
+    const renderer::MapRenderer map_rend(rend_sett);
+    const router::TransportRouter router(rout_sett, catalogue);
+    RequestHandler request_handler(catalogue, map_rend, router);
+    const double load_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - load_start).count();
+
+    if (!options->log_path.empty())
+    {
+        requests = LoadLog(options->log_path);
+    }
+    if (requests.empty())
+    {
+        std::cerr << "No requests to replay"sv << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> type_names;
+    std::vector<size_t> type_by_request;
+    for (const auto &request : requests)
+    {
+        auto it = std::find(type_names.begin(), type_names.end(), request.type);
+        if (it == type_names.end())
+        {
+            it = type_names.insert(type_names.end(), request.type);
+        }
+        type_by_request.push_back(it - type_names.begin());
+    }
+
+    ThreadPool pool(options->threads);
+    // Потоки забирают запросы по очереди из общего счётчика и сразу берутся за следующий
+    const auto run = [&](size_t request_count, bool is_measured)
+    {
+        std::atomic<size_t> next_request = 0;
+        std::vector<std::future<WorkerStats>> workers;
+        for (size_t thread = 0; thread < options->threads; ++thread)
+        {
+            workers.push_back(pool.Submit([&]
+                                          {
+                WorkerStats stats{std::vector<LatencyHistogram>(type_names.size())};
+                std::ostringstream out;
+                for (size_t request = next_request++; request < request_count; request = next_request++)
+                {
+                    const size_t index = request % requests.size();
+                    const auto start = std::chrono::steady_clock::now();
+                    try
+                    {
+                        json::PrintCompact(json::GetResponse(request_handler, requests[index]), out);
+                    }
+                    catch (const std::exception &)
+                    {
+                        // Например, маршрут между остановками, которых нет в базовом документе
+                        ++stats.failed;
+                        out.str({});
+                        continue;
+                    }
+                    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+                    stats.output_bytes += out.tellp();
+                    out.str({});
+                    if (is_measured)
+                    {
+                        stats.histograms[type_by_request[index]].Record(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+                    }
+                }
+                return stats; }));
+        }
+
+        WorkerStats total{std::vector<LatencyHistogram>(type_names.size())};
+        for (auto &worker : workers)
+        {
+            const WorkerStats stats = worker.get();
+            for (size_t type = 0; type < type_names.size(); ++type)
+            {
+                total.histograms[type].Merge(stats.histograms[type]);
+            }
+            total.output_bytes += stats.output_bytes;
+            total.failed += stats.failed;
+        }
+        return total;
+    };
+
+    run(options->warmup, false);
+    const auto replay_start = std::chrono::steady_clock::now();
+    const WorkerStats stats = run(requests.size() * options->repeat, true);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - replay_start).count();
+
+    LatencyHistogram all;
+    for (const auto &histogram : stats.histograms)
+    {
+        all.Merge(histogram);
+    }
+
+    std::cout << std::fixed << std::setprecision(3)
+              << "load: "sv << load_seconds << " s, threads: "sv << options->threads << ", warmup: "sv << options->warmup << '\n'
+              << "replayed: "sv << all.GetCount() << " requests in "sv << seconds << " s, "sv
+              << std::setprecision(0) << all.GetCount() / seconds << " req/s, "sv
+              << std::setprecision(1) << stats.output_bytes / seconds / (1 << 20) << " MiB/s of output"sv;
+    if (stats.failed > 0)
+    {
+        std::cout << ", failed: "sv << stats.failed;
+    }
+    std::cout << "\n\n"sv;
+    std::cout << std::left << std::setw(8) << "type" << std::right << std::setw(10) << "count" << std::setw(12) << "req/s"
+              << std::setw(10) << "mean us" << std::setw(10) << "p50 us" << std::setw(10) << "p95 us" << std::setw(10) << "p99 us"
+              << std::setw(10) << "p99.9 us" << std::setw(12) << "max us" << '\n';
+    for (size_t type = 0; type < type_names.size(); ++type)
+    {
+        PrintRow(type_names[type], stats.histograms[type], seconds);
+    }
+    PrintRow("all"sv, all, seconds);
+
+    if (!options->hgrm_prefix.empty())
+    {
+        for (size_t type = 0; type <= type_names.size(); ++type)
+        {
+            const std::string name = type < type_names.size() ? type_names[type] : "all"s;
+            std::ofstream out(options->hgrm_prefix + "_"s + name + ".hgrm"s);
+            (type < type_names.size() ? stats.histograms[type] : all).PrintPercentileDistribution(out);
+        }
+    }
+}
@@ -1,41 +1,62 @@
 #include "transport_catalogue.h"
 
+#include <algorithm>
+#include <stdexcept>
 #include <unordered_set>
 
 namespace catalogue
 {
     void TransportCatalogue::AddStop(const std::string &name, geo::Coordinates coords)
     {
-        stops_.push_back({name, coords});
-        stopname_to_stop_.insert({stops_.back().stop_name, &stops_.back()});
-        buses_by_stopname_[stops_.back().stop_name];
+        auto stop = std::make_shared<const Stop>(Stop{name, coords});
+        if (const Stop *old_stop = FindStop(name))
+        {
+            // Неизменённая остановка остаётся прежним объектом, чтобы обновление одних расстояний не трогало маршруты
+            if (old_stop->coords == coords)
+            {
+                return;
+            }
+            ReplaceStop(old_stop, std::move(stop));
+            return;
+        }
+
+        stops_.push_back(std::move(stop));
+        stop_index_by_name_.insert({stops_.back()->stop_name, stops_.size() - 1});
+        is_stop_index_built_ = false;
     }
 
     const Stop *TransportCatalogue::FindStop(std::string_view name) const
     {
-        const auto it = stopname_to_stop_.find(name);
-        if (it == stopname_to_stop_.end())
+        const auto it = stop_index_by_name_.find(name);
+        if (it == stop_index_by_name_.end())
         {
             return nullptr;
         }
-        return it->second;
+        return stops_[it->second].get();
     }
 
-    void TransportCatalogue::AddBus(const std::string &name, const std::vector<std::string_view> &stops, bool is_roundtrip)
+    void TransportCatalogue::AddBus(const std::string &name, const std::vector<std::string_view> &stops, bool is_roundtrip, std::vector<double> departures)
     {
         std::vector<const Stop *> bus_stops;
         for (const auto &stop : stops)
         {
-            bus_stops.push_back(stopname_to_stop_.at(stop));
+            bus_stops.push_back(stops_[stop_index_by_name_.at(stop)].get());
         }
 
-        buses_.push_back({name, move(bus_stops), is_roundtrip});
-        busname_to_bus_.insert({buses_.back().bus_name, &buses_.back()});
-
-        for (const auto &stop : stops)
+        if (const Bus *old_bus = FindBus(name))
         {
-            buses_by_stopname_.at(stop).insert(&buses_.back());
+            if (old_bus->bus_stops != bus_stops || old_bus->is_roundtrip != is_roundtrip || old_bus->departures != departures)
+            {
+                ReplaceBus(old_bus, std::make_shared<const Bus>(Bus{name, move(bus_stops), is_roundtrip, move(departures)}));
+            }
+            return;
         }
+
+        auto bus = std::make_shared<const Bus>(Bus{name, move(bus_stops), is_roundtrip, move(departures)});
+        buses_.push_back(std::move(bus));
+        const Bus *added_bus = buses_.back().get();
+        busname_to_bus_.insert({added_bus->bus_name, added_bus});
+        is_stop_index_built_ = false;
     }
 
     const Bus *TransportCatalogue::FindBus(const std::string_view name) const
@@ -57,13 +78,13 @@ namespace catalogue
 
     int TransportCatalogue::GetDistance(const Stop *stop, const Stop *other_stop) const
     {
-        if (distances_by_stops_.count({stop, other_stop}))
+        if (const auto it = distances_by_stops_.find({stop, other_stop}); it != distances_by_stops_.end())
         {
-            return distances_by_stops_.at({stop, other_stop});
+            return it->second;
         }
-        else if (distances_by_stops_.count({other_stop, stop}))
+        else if (const auto it = distances_by_stops_.find({other_stop, stop}); it != distances_by_stops_.end())
         {
-            return distances_by_stops_.at({other_stop, stop});
+            return it->second;
         }
         else
         {
@@ -71,6 +92,37 @@ namespace catalogue
         }
     }
 
+    bool TransportCatalogue::HasSameStopsAndBuses(const TransportCatalogue &other) const
+    {
+        const auto is_same_object = [](const auto &lhs, const auto &rhs)
+        {
+            return lhs.get() == rhs.get();
+        };
+        return std::equal(stops_.begin(), stops_.end(), other.stops_.begin(), other.stops_.end(), is_same_object)
+            && std::equal(buses_.begin(), buses_.end(), other.buses_.begin(), other.buses_.end(), is_same_object);
+    }
+
+    std::vector<std::pair<const Stop *, const Stop *>> TransportCatalogue::GetChangedDistances(const TransportCatalogue &other) const
+    {
+        std::vector<std::pair<const Stop *, const Stop *>> changed;
+        for (const auto &[stops, distance] : distances_by_stops_)
+        {
+            const auto it = other.distances_by_stops_.find(stops);
+            if (it == other.distances_by_stops_.end() || it->second != distance)
+            {
+                changed.push_back(stops);
+            }
+        }
+        for (const auto &[stops, distance] : other.distances_by_stops_)
+        {
+            if (distances_by_stops_.count(stops) == 0)
+            {
+                changed.push_back(stops);
+            }
+        }
+        return changed;
+    }
+
     BusInfo TransportCatalogue::GetBusInfo(std::string_view name) const
     {
         BusInfo bus_info;
@@ -107,30 +159,105 @@ namespace catalogue
         return bus_info;
     }
 
-    const std::unordered_set<const Bus *> &TransportCatalogue::GetStopInfo(std::string_view name) const
+    void TransportCatalogue::BuildStopIndex()
     {
-        static const std::unordered_set<const Bus *> empty;
+        std::vector<const Bus *> sorted_buses;
+        sorted_buses.reserve(buses_.size());
+        for (const auto &bus : buses_)
+        {
+            sorted_buses.push_back(bus.get());
+        }
+        std::sort(sorted_buses.begin(), sorted_buses.end(), [](const Bus *lhs, const Bus *rhs)
+                  { return lhs->bus_name < rhs->bus_name; });
 
-        const auto it = buses_by_stopname_.find(name);
-        if (it != buses_by_stopname_.end())
+        // Маршрут может проходить через остановку несколько раз, а в индекс попадает однажды
+        const size_t stop_count = stops_.size();
+        std::vector<size_t> last_bus(stop_count, sorted_buses.size());
+        const auto for_each_stop_once = [&](size_t bus_index, auto &&action)
         {
-            return it->second;
+            for (const Stop *stop : sorted_buses[bus_index]->bus_stops)
+            {
+                const size_t stop_index = stop_index_by_name_.at(stop->stop_name);
+                if (last_bus[stop_index] != bus_index)
+                {
+                    last_bus[stop_index] = bus_index;
+                    action(stop_index);
+                }
+            }
+        };
+
+        stop_buses_begin_.assign(stop_count + 1, 0);
+        for (size_t i = 0; i < sorted_buses.size(); ++i)
+        {
+            for_each_stop_once(i, [this](size_t stop_index)
+                               { ++stop_buses_begin_[stop_index + 1]; });
+        }
+        for (size_t i = 0; i < stop_count; ++i)
+        {
+            stop_buses_begin_[i + 1] += stop_buses_begin_[i];
+        }
+
+        // Маршруты перебираются по возрастанию названий, поэтому список каждой остановки получается упорядоченным
+        stop_buses_.resize(stop_buses_begin_.back());
+        std::vector<uint32_t> filled(stop_buses_begin_.begin(), stop_buses_begin_.end() - 1);
+        std::fill(last_bus.begin(), last_bus.end(), sorted_buses.size());
+        for (size_t i = 0; i < sorted_buses.size(); ++i)
+        {
+            for_each_stop_once(i, [&](size_t stop_index)
+                               { stop_buses_[filled[stop_index]++] = sorted_buses[i]; });
         }
 
-        return empty;
+        std::vector<std::string_view> stop_names, bus_names;
+        stop_names.reserve(stops_.size());
+        for (const auto &stop : stops_)
+        {
+            stop_names.push_back(stop->stop_name);
+        }
+        bus_names.reserve(buses_.size());
+        for (const auto &bus : buses_)
+        {
+            bus_names.push_back(bus->bus_name);
+        }
+        name_index_ = NameIndex(stop_names, bus_names);
+
+        is_stop_index_built_ = true;
     }
 
-    const std::unordered_map<std::string_view, const Bus *> &TransportCatalogue::GetBusNameToBus() const
+    TransportCatalogue::BusRange TransportCatalogue::GetStopInfo(std::string_view name) const
+    {
+        if (!is_stop_index_built_)
+        {
+            throw std::logic_error("Stop index is out of date, call BuildStopIndex after changing the catalogue");
+        }
+
+        const auto it = stop_index_by_name_.find(name);
+        if (it == stop_index_by_name_.end())
+        {
+            return {stop_buses_.end(), stop_buses_.end()};
+        }
+        return {stop_buses_.begin() + stop_buses_begin_[it->second], stop_buses_.begin() + stop_buses_begin_[it->second + 1]};
+    }
+
+    const NameIndex &TransportCatalogue::GetNameIndex() const
+    {
+        if (!is_stop_index_built_)
+        {
+            throw std::logic_error("Name index is out of date, call BuildStopIndex after changing the catalogue");
+        }
+        return name_index_;
+    }
+
+    const BusNameIndex &TransportCatalogue::GetBusNameToBus() const
     {
         return busname_to_bus_;
     }
 
-    const std::deque<Bus> &TransportCatalogue::GetBusList() const
+    const TransportCatalogue::BusList &TransportCatalogue::GetBusList() const
     {
         return buses_;
     }
 
-    const std::deque<Stop> &TransportCatalogue::GetStopList() const
+    const TransportCatalogue::StopList &TransportCatalogue::GetStopList() const
     {
         return stops_;
     }
@@ -139,4 +266,86 @@ namespace catalogue
     {
         return stops_.size();
     }
-}
+
+    void TransportCatalogue::AddMemoryUsage(MemoryUsage &usage) const
+    {
+        size_t stop_bytes = stops_.capacity() * sizeof(StopList::value_type);
+        for (const auto &stop : stops_)
+        {
+            stop_bytes += SHARED_CONTROL_BLOCK + sizeof(Stop) + GetHeapBytes(stop->stop_name);
+        }
+        usage.Add("catalogue.stops", stop_bytes);
+
+        size_t bus_bytes = buses_.capacity() * sizeof(BusList::value_type);
+        for (const auto &bus : buses_)
+        {
+            bus_bytes += SHARED_CONTROL_BLOCK + sizeof(Bus) + GetHeapBytes(bus->bus_name) + GetHeapBytes(bus->bus_stops) + GetHeapBytes(bus->departures);
+        }
+        usage.Add("catalogue.buses", bus_bytes);
+
+        usage.Add("catalogue.stop_index", stop_index_by_name_.GetMemoryUsage());
+        usage.Add("catalogue.bus_index", busname_to_bus_.GetMemoryUsage());
+        usage.Add("catalogue.distances", distances_by_stops_.GetMemoryUsage());
+        usage.Add("catalogue.stop_buses", GetHeapBytes(stop_buses_begin_) + GetHeapBytes(stop_buses_));
+        usage.Add("catalogue.name_index", name_index_.GetMemoryUsage());
+    }
+
+    void TransportCatalogue::ReplaceStop(const Stop *old_stop, std::shared_ptr<const Stop> new_stop)
+    {
+        // Ключи индексов ссылаются на название старой остановки, поэтому она живёт до конца замены
+        const auto position = std::find_if(stops_.begin(), stops_.end(), [old_stop](const auto &stop)
+                                           { return stop.get() == old_stop; });
+        const std::shared_ptr<const Stop> old_holder = std::move(*position);
+        *position = std::move(new_stop);
+        const Stop *stop = position->get();
+
+        stop_index_by_name_.erase(old_stop->stop_name);
+        stop_index_by_name_.insert({stop->stop_name, size_t(position - stops_.begin())});
+        is_stop_index_built_ = false;
+
+        std::vector<std::pair<std::pair<const Stop *, const Stop *>, int>> distances;
+        for (auto it = distances_by_stops_.begin(); it != distances_by_stops_.end();)
+        {
+            const auto [from, to] = it->first;
+            if (from == old_stop || to == old_stop)
+            {
+                distances.push_back({{from == old_stop ? stop : from, to == old_stop ? stop : to}, it->second});
+                it = distances_by_stops_.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        distances_by_stops_.insert(distances.begin(), distances.end());
+
+        // Замены случаются только при обновлениях, поэтому затронутые маршруты ищутся перебором
+        std::vector<const Bus *> affected_buses;
+        for (const auto &bus : buses_)
+        {
+            if (std::find(bus->bus_stops.begin(), bus->bus_stops.end(), old_stop) != bus->bus_stops.end())
+            {
+                affected_buses.push_back(bus.get());
+            }
+        }
+        for (const Bus *bus : affected_buses)
+        {
+            Bus new_bus = *bus;
+            std::replace(new_bus.bus_stops.begin(), new_bus.bus_stops.end(), old_stop, stop);
+            ReplaceBus(bus, std::make_shared<const Bus>(std::move(new_bus)));
+        }
+    }
+
+    void TransportCatalogue::ReplaceBus(const Bus *old_bus, std::shared_ptr<const Bus> new_bus)
+    {
+        const auto position = std::find_if(buses_.begin(), buses_.end(), [old_bus](const auto &bus)
+                                           { return bus.get() == old_bus; });
+        const std::shared_ptr<const Bus> old_holder = std::move(*position);
+        *position = std::move(new_bus);
+        const Bus *bus = position->get();
+
+        busname_to_bus_.erase(old_bus->bus_name);
+        busname_to_bus_.insert({bus->bus_name, bus});
+        is_stop_index_built_ = false;
+    }
+}
\ No newline at end of file
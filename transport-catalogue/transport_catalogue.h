@@ -1,22 +1,35 @@
 #pragma once
 
 #include "domain.h"
+#include "flat_hash_map.h"
+#include "memory_usage.h"
+#include "name_index.h"
+#include "ranges.h"
 
-#include <deque>
+#include <cstdint>
+#include <memory>
 #include <optional>
-#include <unordered_map>
-#include <unordered_set>
+#include <vector>
 
 namespace catalogue
 {
+	/*
+	 * Остановки и маршруты неизменяемы и принадлежат справочнику совместно с его копиями:
+	 * копия справочника разделяет с оригиналом все объекты и копирует только индексы.
+	 * Повторное добавление остановки или маршрута с тем же названием заменяет объект в этой копии
+	 */
 	class TransportCatalogue
 	{
 	public:
+		using StopList = std::vector<std::shared_ptr<const Stop>>;
+		using BusList = std::vector<std::shared_ptr<const Bus>>;
+		using BusRange = ranges::Range<std::vector<const Bus *>::const_iterator>;
+
 		void AddStop(const std::string &name, geo::Coordinates coords);
 
 		const Stop *FindStop(std::string_view name) const;
 
-		void AddBus(const std::string &name, const std::vector<std::string_view> &routes, bool is_roundtrip);
+		void AddBus(const std::string &name, const std::vector<std::string_view> &routes, bool is_roundtrip, std::vector<double> departures = {});
 
 		const Bus *FindBus(std::string_view name) const;
 
@@ -24,32 +37,61 @@ namespace catalogue
 
 		int GetDistance(const Stop *, const Stop *) const;
 
+		// Истинно, если копии разделяют одни и те же объекты остановок и маршрутов в том же порядке
+		bool HasSameStopsAndBuses(const TransportCatalogue &other) const;
+
+		// Пары остановок, для которых явно заданное расстояние отличается от заданного в other
+		std::vector<std::pair<const Stop *, const Stop *>> GetChangedDistances(const TransportCatalogue &other) const;
+
 		BusInfo GetBusInfo(std::string_view name) const;
 
-		const std::unordered_set<const Bus *> &GetStopInfo(std::string_view name) const;
+		// Строит для каждой остановки упорядоченный по названиям список проходящих через неё маршрутов
+		// и индекс поиска названий по началу. Вызывается после загрузки и после каждого изменения остановок или маршрутов
+		void BuildStopIndex();
+
+		// Маршруты через остановку в порядке названий; для неизвестной остановки — пустой диапазон
+		BusRange GetStopInfo(std::string_view name) const;
+
+		// Поиск остановок и маршрутов по началу названия, построенный BuildStopIndex
+		const NameIndex &GetNameIndex() const;
 
-		const std::unordered_map<std::string_view, const Bus *> &GetBusNameToBus() const;
+		const BusNameIndex &GetBusNameToBus() const;
 
-		const std::deque<Bus> &GetBusList() const;
+		// Маршруты и остановки в порядке добавления
+		const BusList &GetBusList() const;
 
-		const std::deque<Stop> &GetStopList() const;
+		const StopList &GetStopList() const;
 
 		int GetStopCount() const;
 
+		// Добавляет в usage память индексов и объектов остановок и маршрутов. Объекты, общие с другими
+		// копиями справочника, учитываются в каждой копии
+		void AddMemoryUsage(MemoryUsage &usage) const;
+
 	private:
 		struct StopPtrHasher
 		{
 			size_t operator()(std::pair<const Stop *, const Stop *> const &stops_ptr) const
 			{
-				return std::hash<const Stop *>()(stops_ptr.first) * 37 + std::hash<const Stop *>()(stops_ptr.second) * 37 * 37;
+				return MixHash(std::hash<const Stop *>()(stops_ptr.first)) + std::hash<const Stop *>()(stops_ptr.second);
 			}
 		};
 
-		std::deque<Stop> stops_;
-		std::unordered_map<std::string_view, const Stop *> stopname_to_stop_;
-		std::unordered_map<std::pair<const Stop *, const Stop *>, int, StopPtrHasher> distances_by_stops_;
-		std::unordered_map<std::string_view, std::unordered_set<const Bus *>> buses_by_stopname_;
-		std::deque<Bus> buses_;
-		std::unordered_map<std::string_view, const Bus *> busname_to_bus_;
+		// Заменяет остановку новым объектом и перестраивает проходящие через неё маршруты
+		void ReplaceStop(const Stop *old_stop, std::shared_ptr<const Stop> new_stop);
+
+		void ReplaceBus(const Bus *old_bus, std::shared_ptr<const Bus> new_bus);
+
+		StopList stops_;
+		FlatHashMap<std::string_view, size_t> stop_index_by_name_;
+		FlatHashMap<std::pair<const Stop *, const Stop *>, int, StopPtrHasher> distances_by_stops_;
+		BusList buses_;
+		BusNameIndex busname_to_bus_;
+
+		// Маршруты остановки stops_[i]: stop_buses_[stop_buses_begin_[i]..stop_buses_begin_[i + 1])
+		std::vector<uint32_t> stop_buses_begin_;
+		std::vector<const Bus *> stop_buses_;
+		NameIndex name_index_;
+		bool is_stop_index_built_ = false;
 	};
 }
@@ -1,6 +1,9 @@
 #include "transport_router.h"
+#include "metrics.h"
 
+#include <cmath>
 #include <iostream>
+#include <unordered_set>
 
 namespace catalogue
 {
@@ -8,54 +11,205 @@ namespace catalogue
     {
 
         TransportRouter::TransportRouter(const RouterSettings &rout_sett, const TransportCatalogue &catalogue)
-            : wait_time_(rout_sett.wait_time), bus_velocity_(rout_sett.bus_velocity)
+            : settings_(rout_sett),
+              arena_(std::make_unique<ArenaResource>(rout_sett.huge_pages)),
+              graph_(catalogue.GetStopCount() * 2, arena_.get()),
+              integer_graph_(rout_sett.integer_weights ? graph_.GetVertexCount() : 0, arena_.get()),
+              raptor_(rout_sett, catalogue), route_cache_size_(rout_sett.route_cache_size), route_cache_(route_cache_size_)
         {
-            const size_t vertex_count = catalogue.GetStopCount() * 2;
-            graph_ = graph::DirectedWeightedGraph<double>(vertex_count);
-            BuildGraph(catalogue);
+            BuildGraph(catalogue, rout_sett);
         }
 
-        void TransportRouter::BuildGraph(const TransportCatalogue &catalogue)
+        TransportRouter::TransportRouter(const TransportRouter &other)
+            : settings_(other.settings_), vert_id_by_stop_(other.vert_id_by_stop_),
+              first_edge_by_bus_(other.first_edge_by_bus_), arena_(std::make_unique<ArenaResource>(other.arena_->IsUsingHugePages())),
+              graph_(other.graph_, arena_.get()), integer_graph_(other.integer_graph_, arena_.get()),
+              raptor_(other.raptor_), route_cache_size_(other.route_cache_size_), route_cache_(route_cache_size_)
         {
-            AddStops(catalogue.GetStopList());
-            for (const auto &bus : catalogue.GetBusList())
-            {
-                size_t from, to;
-                bool is_round = bus.is_roundtrip;
-                const auto &stops = bus.bus_stops;
-                const int stop_count = stops.size();
-                for (int i = 0; i < stop_count; ++i)
+            if (other.router_)
+            {
+                router_ = std::make_unique<graph::Router<double>>(graph_, *other.router_, arena_.get());
+            }
+            else if (other.alt_router_)
+            {
+                alt_router_ = std::make_unique<graph::AltRouter<double>>(graph_, *other.alt_router_);
+            }
+            else if (other.integer_router_)
+            {
+                integer_router_ = std::make_unique<graph::Router<int64_t>>(integer_graph_, *other.integer_router_, arena_.get());
+            }
+            else
+            {
+                integer_alt_router_ = std::make_unique<graph::AltRouter<int64_t>>(integer_graph_, *other.integer_alt_router_);
+            }
+        }
+
+        void TransportRouter::BuildGraph(const TransportCatalogue &catalogue, const RouterSettings &rout_sett)
+        {
+            {
+                metrics::ScopedTimer timer(metrics::RecordPhase, "build_graph");
+                // Рёбра собираются заранее, чтобы граф выделил в арене память ровно под них
+                std::vector<graph::Edge<double>> edges;
+                AddStops(catalogue.GetStopList(), edges);
+                for (const auto &bus : catalogue.GetBusList())
+                {
+                    first_edge_by_bus_[bus.get()] = edges.size();
+                    const std::vector<graph::Edge<double>> bus_edges = MakeBusEdges(catalogue, *bus);
+                    edges.insert(edges.end(), bus_edges.begin(), bus_edges.end());
+                }
+                graph_.AddEdges(edges);
+            }
+
+            metrics::ScopedTimer timer(metrics::RecordPhase, "build_router");
+            if (rout_sett.integer_weights)
+            {
+                std::vector<graph::Edge<int64_t>> integer_edges;
+                integer_edges.reserve(graph_.GetEdgeCount());
+                for (graph::EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id)
+                {
+                    const auto &edge = graph_.GetEdge(edge_id);
+                    integer_edges.push_back({edge.from, edge.to, QuantizeWeight(edge.weight), edge.span_count, edge.name});
+                }
+                integer_graph_.AddEdges(integer_edges);
+                if (rout_sett.engine == RouterEngine::ALT)
+                {
+                    integer_alt_router_ = std::make_unique<graph::AltRouter<int64_t>>(integer_graph_, rout_sett.landmark_count);
+                }
+                else
+                {
+                    integer_router_ = std::make_unique<graph::Router<int64_t>>(integer_graph_, arena_.get());
+                }
+            }
+            else if (rout_sett.engine == RouterEngine::ALT)
+            {
+                alt_router_ = std::make_unique<graph::AltRouter<double>>(graph_, rout_sett.landmark_count);
+            }
+            else
+            {
+                router_ = std::make_unique<graph::Router<double>>(graph_, arena_.get());
+            }
+        }
+
+        int64_t TransportRouter::QuantizeWeight(double weight) const
+        {
+            return std::llround(weight * WEIGHT_UNITS_PER_MINUTE);
+        }
+
+        std::vector<graph::Edge<double>> TransportRouter::MakeBusEdges(const TransportCatalogue &catalogue, const Bus &bus) const
+        {
+            std::vector<graph::Edge<double>> edges;
+            size_t from, to;
+            bool is_round = bus.is_roundtrip;
+            const auto &stops = bus.bus_stops;
+            const int stop_count = stops.size();
+            for (int i = 0; i < stop_count; ++i)
+            {
+                from = vert_id_by_stop_.at(stops[i]);
+                double distance = 0.0, reverse_dist = 0.0;
+                for (int j = i + 1; j < stop_count; ++j)
+                {
+                    to = vert_id_by_stop_.at(stops[j]);
+                    distance += catalogue.GetDistance(stops[j - 1], stops[j]);
+                    edges.push_back({from + 1, to, distance / (settings_.bus_velocity * (METERS_PER_KILOMETER / MIN_PER_HOUR)), j - i, bus.bus_name});
+                    if (!is_round)
+                    {
+                        reverse_dist += catalogue.GetDistance(stops[j], stops[j - 1]);
+                        edges.push_back({to + 1, from, reverse_dist / (settings_.bus_velocity * (METERS_PER_KILOMETER / MIN_PER_HOUR)), j - i, bus.bus_name});
+                    }
+                }
+            }
+            return edges;
+        }
+
+        void TransportRouter::UpdateDistances(const TransportCatalogue &catalogue, const std::vector<std::pair<const Stop *, const Stop *>> &changed_stops)
+        {
+            metrics::ScopedTimer timer(metrics::RecordPhase, "update_router");
+            // Расстояние между парой задаётся в любую сторону, поэтому затронуты маршруты, где остановки соседние в любом порядке
+            std::unordered_set<const Bus *> affected_buses;
+            for (const auto &[stop, other_stop] : changed_stops)
+            {
+                for (const Bus *bus : catalogue.GetStopInfo(stop->stop_name))
+                {
+                    const auto &stops = bus->bus_stops;
+                    for (size_t i = 1; i < stops.size(); ++i)
+                    {
+                        if ((stops[i - 1] == stop && stops[i] == other_stop) || (stops[i - 1] == other_stop && stops[i] == stop))
+                        {
+                            affected_buses.insert(bus);
+                            break;
+                        }
+                    }
+                }
+            }
+
+            std::vector<std::pair<graph::EdgeId, double>> changed_edges;
+            std::vector<std::pair<graph::EdgeId, int64_t>> changed_integer_edges;
+            for (const Bus *bus : affected_buses)
+            {
+                graph::EdgeId edge_id = first_edge_by_bus_.at(bus);
+                for (const auto &edge : MakeBusEdges(catalogue, *bus))
                 {
-                    from = vert_id_by_stop_.at(stops[i]);
-                    double distance = 0.0, reverse_dist = 0.0;
-                    for (int j = i + 1; j < stop_count; ++j)
+                    const double old_weight = graph_.GetEdge(edge_id).weight;
+                    if (edge.weight != old_weight)
                     {
-                        to = vert_id_by_stop_.at(stops[j]);
-                        distance += catalogue.GetDistance(stops[j - 1], stops[j]);
-                        graph_.AddEdge({from + 1, to, distance / (bus_velocity_ * (METERS_PER_KILOMETER / MIN_PER_HOUR)), j - i, bus.bus_name});
-                        if (!is_round)
+                        graph_.SetEdgeWeight(edge_id, edge.weight);
+                        changed_edges.push_back({edge_id, old_weight});
+                        if (settings_.integer_weights)
                         {
-                            reverse_dist += catalogue.GetDistance(stops[j], stops[j - 1]);
-                            graph_.AddEdge({to + 1, from, reverse_dist / (bus_velocity_ * (METERS_PER_KILOMETER / MIN_PER_HOUR)), j - i, bus.bus_name});
+                            const int64_t old_integer_weight = integer_graph_.GetEdge(edge_id).weight;
+                            if (const int64_t integer_weight = QuantizeWeight(edge.weight); integer_weight != old_integer_weight)
+                            {
+                                integer_graph_.SetEdgeWeight(edge_id, integer_weight);
+                                changed_integer_edges.push_back({edge_id, old_integer_weight});
+                            }
                         }
                     }
+                    ++edge_id;
                 }
             }
 
-            router_ = std::make_unique<graph::Router<double>>(graph_);
+            if (!changed_edges.empty())
+            {
+                if (router_)
+                {
+                    router_->UpdateEdgeWeights(changed_edges);
+                }
+                else if (alt_router_)
+                {
+                    alt_router_->UpdateEdgeWeights();
+                }
+                else if (integer_router_)
+                {
+                    integer_router_->UpdateEdgeWeights(changed_integer_edges);
+                }
+                else
+                {
+                    integer_alt_router_->UpdateEdgeWeights();
+                }
+                route_cache_.Clear();
+
+                // Раскладка RAPTOR строится за линейное время, её проще построить заново
+                raptor_ = RaptorRouter(settings_, catalogue);
+            }
         }
 
         std::optional<TransportRouter::RouteInfo> TransportRouter::GetShortestRoute(const Stop *from, const Stop *to) const
         {
-            RouteInfo route_info;
-            const auto &short_route = router_->BuildRoute(vert_id_by_stop_.at(from), vert_id_by_stop_.at(to));
-
-            if (!short_route)
+            const std::pair<size_t, size_t> vertices{vert_id_by_stop_.at(from), vert_id_by_stop_.at(to)};
+            std::optional<std::vector<uint32_t>> edge_ids = route_cache_.Get(vertices);
+            if (!edge_ids)
             {
-                return std::nullopt;
+                edge_ids = FindRouteEdges(vertices.first, vertices.second);
+                if (!edge_ids)
+                {
+                    return std::nullopt;
+                }
+                route_cache_.Put(vertices, *edge_ids);
             }
 
-            for (const auto &edge_id : short_route->edges)
+            RouteInfo route_info;
+            route_info.reserve(edge_ids->size());
+            for (const auto edge_id : *edge_ids)
             {
                 route_info.push_back(graph_.GetEdge(edge_id));
             }
@@ -63,13 +217,141 @@ namespace catalogue
             return route_info;
         }
 
-        void TransportRouter::AddStops(const std::deque<Stop> &stops)
+        std::optional<std::vector<uint32_t>> TransportRouter::FindRouteEdges(size_t from, size_t to) const
+        {
+            // Поиск пути без кэша: время самого запроса Route включает ещё и вывод ответа
+            metrics::ScopedTimer timer(metrics::RecordPhase, "route_search");
+            const auto to_edge_ids = [](const auto &route) -> std::optional<std::vector<uint32_t>>
+            {
+                if (!route)
+                {
+                    return std::nullopt;
+                }
+                return std::vector<uint32_t>(route->edges.begin(), route->edges.end());
+            };
+
+            if (router_)
+            {
+                return to_edge_ids(router_->BuildRoute(from, to));
+            }
+            if (alt_router_)
+            {
+                return to_edge_ids(alt_router_->BuildRoute(from, to));
+            }
+            if (integer_router_)
+            {
+                return to_edge_ids(integer_router_->BuildRoute(from, to));
+            }
+            return to_edge_ids(integer_alt_router_->BuildRoute(from, to));
+        }
+
+        TransportRouter::RouteCache::Stats TransportRouter::GetRouteCacheStats() const
+        {
+            return route_cache_.GetStats();
+        }
+
+        const graph::DirectedWeightedGraph<double> &TransportRouter::GetGraph() const
+        {
+            return graph_;
+        }
+
+        PageBacking TransportRouter::GetPageBacking() const
+        {
+            return arena_->GetPageBacking();
+        }
+
+        void TransportRouter::AddMemoryUsage(MemoryUsage &usage) const
+        {
+            usage.Add("router.vertex_index", vert_id_by_stop_.GetMemoryUsage() + first_edge_by_bus_.GetMemoryUsage());
+            usage.Add("router.graph", graph_.GetMemoryUsage());
+            if (router_)
+            {
+                usage.Add("router.routes", router_->GetMemoryUsage());
+            }
+            else if (alt_router_)
+            {
+                usage.Add("router.landmarks", alt_router_->GetMemoryUsage());
+            }
+            else if (integer_router_)
+            {
+                usage.Add("router.integer_graph", integer_graph_.GetMemoryUsage());
+                usage.Add("router.routes", integer_router_->GetMemoryUsage());
+            }
+            else
+            {
+                usage.Add("router.integer_graph", integer_graph_.GetMemoryUsage());
+                usage.Add("router.landmarks", integer_alt_router_->GetMemoryUsage());
+            }
+            // Хвосты кусков арены, которые уже не пойдут в дело
+            usage.Add("router.arena_wasted", arena_->GetWastedBytes());
+            usage.Add("router.raptor", raptor_.GetMemoryUsage());
+            usage.Add("router.route_cache", route_cache_.GetMemoryUsage());
+        }
+
+        std::vector<TransportRouter::RouteInfo> TransportRouter::GetAlternativeRoutes(const Stop *from, const Stop *to, size_t count) const
+        {
+            // Пересадка на тот же автобус не даёт нового варианта поездки
+            const auto has_no_reboarding = [this](const std::vector<graph::EdgeId> &edges)
+            {
+                std::string_view previous_bus;
+                for (const auto edge_id : edges)
+                {
+                    const auto &edge = graph_.GetEdge(edge_id);
+                    if (edge.span_count > 0)
+                    {
+                        if (edge.name == previous_bus)
+                        {
+                            return false;
+                        }
+                        previous_bus = edge.name;
+                    }
+                }
+                return true;
+            };
+
+            // Запасные маршруты даёт только таблица всех пар
+            const auto build_routes = [&](const auto &router)
+            {
+                std::vector<RouteInfo> routes;
+                for (const auto &route : router.BuildAlternativeRoutes(vert_id_by_stop_.at(from), vert_id_by_stop_.at(to), count, has_no_reboarding))
+                {
+                    RouteInfo &route_info = routes.emplace_back();
+                    for (const auto &edge_id : route.edges)
+                    {
+                        route_info.push_back(graph_.GetEdge(edge_id));
+                    }
+                }
+                return routes;
+            };
+            if (router_)
+            {
+                return build_routes(*router_);
+            }
+            if (integer_router_)
+            {
+                return build_routes(*integer_router_);
+            }
+
+            std::vector<RouteInfo> routes;
+            if (auto route = GetShortestRoute(from, to); route && count > 0)
+            {
+                routes.push_back(std::move(*route));
+            }
+            return routes;
+        }
+
+        std::optional<TransportRouter::RouteInfo> TransportRouter::GetEarliestArrivalRoute(const Stop *from, const Stop *to, double departure_time) const
+        {
+            return raptor_.GetEarliestArrivalRoute(from, to, departure_time);
+        }
+
+        void TransportRouter::AddStops(const TransportCatalogue::StopList &stops, std::vector<graph::Edge<double>> &edges)
         {
             size_t index = 0;
             for (const auto &stop : stops)
             {
-                vert_id_by_stop_[&stop] = index;
-                graph_.AddEdge({index, index + 1, wait_time_, 0, stop.stop_name});
+                vert_id_by_stop_[stop.get()] = index;
+                edges.push_back({index, index + 1, settings_.wait_time, 0, stop->stop_name});
                 index += 2;
             }
         }
@@ -1,19 +1,46 @@
 #pragma once
 
+#include "alt_router.h"
+#include "arena.h"
+#include "flat_hash_map.h"
+#include "lru_cache.h"
+#include "raptor.h"
 #include "router.h"
 #include "transport_catalogue.h"
 
-#include <deque>
 #include <memory>
+#include <utility>
+#include <vector>
 
 namespace catalogue
 {
     namespace router
     {
+        // Способ поиска кратчайших маршрутов
+        enum class RouterEngine
+        {
+            // Маршруты между всеми парами вершин предпосчитаны: ответ мгновенный, память квадратична
+            ALL_PAIRS,
+            // Поиск A* по ориентирам на каждый запрос: память и предподсчёт линейны
+            ALT,
+        };
+
         struct RouterSettings
         {
             double wait_time;
             double bus_velocity;
+            // Сколько последних ответов GetShortestRoute хранить; 0 отключает кэш
+            size_t route_cache_size = 1 << 16;
+            RouterEngine engine = RouterEngine::ALL_PAIRS;
+            // Число ориентиров для RouterEngine::ALT
+            size_t landmark_count = 16;
+            // Искать путь по весам в целых десятых долях секунды. Сравнения дешевле, равные по времени пути
+            // выбираются однозначно, очередь поиска — поразрядная куча (для ALL_PAIRS — при частичном пересчёте строк).
+            // Время в ответах по-прежнему считается по точным весам рёбер в минутах
+            bool integer_weights = false;
+            // Разместить граф и таблицу маршрутов на больших страницах по 2 МиБ, если ОС их даёт.
+            // Таблица читается вразнобой, и на больших городах промахи TLB заметны во времени ответа
+            bool huge_pages = false;
         };
 
         class TransportRouter
@@ -21,23 +48,84 @@ namespace catalogue
         public:
             const double METERS_PER_KILOMETER = 1000.0;
             const double MIN_PER_HOUR = 60.0;
+            const double WEIGHT_UNITS_PER_MINUTE = 600.0;
             using RouteInfo = std::vector<graph::Edge<double>>;
 
+            struct VertexPairHasher
+            {
+                size_t operator()(const std::pair<size_t, size_t> &vertices) const
+                {
+                    return MixHash(vertices.first) + vertices.second;
+                }
+            };
+            // Найденные маршруты хранятся номерами рёбер графа
+            using RouteCache = ShardedLruCache<std::pair<size_t, size_t>, std::vector<uint32_t>, VertexPairHasher>;
+
             TransportRouter(const RouterSettings &rout_sett, const TransportCatalogue &catalogue);
 
+            // Копия разделяет с other только объекты остановок и маршрутов, предпосчитанные маршруты копируются.
+            // Кэш ответов у копии начинается пустым
+            TransportRouter(const TransportRouter &other);
+
             std::optional<RouteInfo> GetShortestRoute(const Stop *from, const Stop *to) const;
 
+            RouteCache::Stats GetRouteCacheStats() const;
+
+            const graph::DirectedWeightedGraph<double> &GetGraph() const;
+
+            // Рёбра маршрута в порядке добавления в граф
+            std::vector<graph::Edge<double>> MakeBusEdges(const TransportCatalogue &catalogue, const Bus &bus) const;
+
+            // До count различных маршрутов без петель по возрастанию времени; первый совпадает с GetShortestRoute.
+            // С RouterEngine::ALT запасные маршруты не ищутся, возвращается только кратчайший
+            std::vector<RouteInfo> GetAlternativeRoutes(const Stop *from, const Stop *to, size_t count) const;
+
+            // Поездка по расписанию с самым ранним прибытием, см. RaptorRouter
+            std::optional<RouteInfo> GetEarliestArrivalRoute(const Stop *from, const Stop *to, double departure_time) const;
+
+            // Пересчитывает веса рёбер маршрутов, проходящих между изменившимися парами остановок, и обновляет
+            // только затронутые маршруты между вершинами. Остановки и маршруты в catalogue должны быть теми же,
+            // что при построении, иначе нужен новый TransportRouter
+            void UpdateDistances(const TransportCatalogue &catalogue, const std::vector<std::pair<const Stop *, const Stop *>> &changed_stops);
+
+            // Какие страницы ОС достались арене графа и таблицы маршрутов, см. RouterSettings::huge_pages
+            PageBacking GetPageBacking() const;
+
+            // Добавляет в usage память графа, предпосчитанных маршрутов, раскладки RAPTOR и кэша ответов
+            void AddMemoryUsage(MemoryUsage &usage) const;
+
         private:
-            double wait_time_;
-            double bus_velocity_;
-            std::unordered_map<const Stop *, size_t> vert_id_by_stop_;
+            // Настройки построения: по ним же заново строится раскладка RAPTOR при обновлении расстояний
+            RouterSettings settings_;
+            FlatHashMap<const Stop *, size_t> vert_id_by_stop_;
+            // Рёбра каждого маршрута добавляются подряд начиная с этого номера
+            FlatHashMap<const Bus *, graph::EdgeId> first_edge_by_bus_;
 
+            // Память графов и таблицы маршрутов: они строятся один раз, поэтому арена монотонная.
+            // Объявлена раньше них, чтобы освобождаться после
+            std::unique_ptr<ArenaResource> arena_;
             graph::DirectedWeightedGraph<double> graph_;
+            // Строится ровно один из маршрутизаторов, по RouterSettings::engine и integer_weights
             std::unique_ptr<graph::Router<double>> router_;
+            std::unique_ptr<graph::AltRouter<double>> alt_router_;
+            // Копия graph_ с весами в единицах WEIGHT_UNITS_PER_MINUTE и теми же номерами рёбер
+            graph::DirectedWeightedGraph<int64_t> integer_graph_;
+            std::unique_ptr<graph::Router<int64_t>> integer_router_;
+            std::unique_ptr<graph::AltRouter<int64_t>> integer_alt_router_;
+            RaptorRouter raptor_;
+
+            size_t route_cache_size_;
+            mutable RouteCache route_cache_;
+
+            void BuildGraph(const TransportCatalogue &catalogue, const RouterSettings &rout_sett);
+
+            int64_t QuantizeWeight(double weight) const;
 
-            void BuildGraph(const TransportCatalogue &catalogue);
+            // Номера рёбер кратчайшего пути между вершинами графа
+            std::optional<std::vector<uint32_t>> FindRouteEdges(size_t from, size_t to) const;
 
-            void AddStops(const std::deque<Stop> &stops);
+            // Рёбра ожидания на остановках; заодно нумерует вершины
+            void AddStops(const TransportCatalogue::StopList &stops, std::vector<graph::Edge<double>> &edges);
         };
     }
 }
@@ -0,0 +1,169 @@
+#include "versioned_catalogue.h"
+#include "metrics.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <thread>
+
+namespace catalogue
+{
+    struct VersionedCatalogue::Version
+    {
+        Version(uint64_t version_number, TransportCatalogue catalogue_data, renderer::RenderSettings &render_settings, const router::RouterSettings &router_settings, ThreadPool *render_pool)
+            : number(version_number),
+              catalogue(std::move(catalogue_data)),
+              renderer(render_settings),
+              router(router_settings, catalogue),
+              handler(catalogue, renderer, router, render_pool) {}
+
+        // Версия, в которой изменились только расстояния: маршрутизатор копируется у предыдущей и обновляется частично
+        Version(uint64_t version_number, TransportCatalogue catalogue_data, const Version &previous, const std::vector<std::pair<const Stop *, const Stop *>> &changed_stops, renderer::RenderSettings &render_settings, ThreadPool *render_pool)
+            : number(version_number),
+              catalogue(std::move(catalogue_data)),
+              renderer(render_settings),
+              router(previous.router),
+              handler(catalogue, renderer, router, render_pool)
+        {
+            router.UpdateDistances(catalogue, changed_stops);
+        }
+
+        const uint64_t number;
+        const TransportCatalogue catalogue;
+        // Кэши отрисовки привязаны к адресам маршрутов, поэтому у каждой версии свои
+        const renderer::MapRenderer renderer;
+        // Изменяется только в конструкторе, до публикации версии
+        router::TransportRouter router;
+        RequestHandler handler;
+    };
+
+    //------------ReadGuard------------
+
+    VersionedCatalogue::ReadGuard::ReadGuard(const VersionedCatalogue &versions, std::atomic<uint64_t> &slot, Version *version)
+        : versions_(versions), slot_(slot), version_(version) {}
+
+    VersionedCatalogue::ReadGuard::~ReadGuard()
+    {
+        slot_.store(0);
+        if (versions_.retired_count_.load() != 0)
+        {
+            versions_.RequestReclaim();
+        }
+    }
+
+    uint64_t VersionedCatalogue::ReadGuard::GetNumber() const
+    {
+        return version_->number;
+    }
+
+    const TransportCatalogue &VersionedCatalogue::ReadGuard::GetCatalogue() const
+    {
+        return version_->catalogue;
+    }
+
+    RequestHandler &VersionedCatalogue::ReadGuard::GetHandler() const
+    {
+        return version_->handler;
+    }
+
+    //------------VersionedCatalogue------------
+
+    VersionedCatalogue::VersionedCatalogue(TransportCatalogue catalogue, renderer::RenderSettings &render_settings, const router::RouterSettings &router_settings, ThreadPool *render_pool)
+        : render_settings_(render_settings), router_settings_(router_settings), render_pool_(render_pool),
+          current_(new Version(1, std::move(catalogue), render_settings, router_settings, render_pool)) {}
+
+    VersionedCatalogue::~VersionedCatalogue()
+    {
+        delete current_.load();
+    }
+
+    VersionedCatalogue::ReadGuard VersionedCatalogue::Read() const
+    {
+        // Поток начинает поиск свободной ячейки с той, что занимал в прошлый раз
+        thread_local size_t slot_hint = std::hash<std::thread::id>{}(std::this_thread::get_id());
+
+        const uint64_t epoch = global_epoch_.load();
+        for (size_t attempt = 0;; ++attempt)
+        {
+            const size_t index = (slot_hint + attempt) % READER_SLOT_COUNT;
+            uint64_t expected = 0;
+            if (reader_slots_[index].epoch.compare_exchange_strong(expected, epoch))
+            {
+                slot_hint = index;
+                // Версия читается после объявления эпохи: писатель либо увидит эпоху, либо уже опубликовал новую версию
+                return ReadGuard(*this, reader_slots_[index].epoch, current_.load());
+            }
+            if (attempt % READER_SLOT_COUNT == READER_SLOT_COUNT - 1)
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    uint64_t VersionedCatalogue::Update(const std::function<void(TransportCatalogue &)> &apply)
+    {
+        std::lock_guard lock(update_mutex_);
+        metrics::ScopedTimer timer(metrics::RecordPhase, "update");
+
+        const Version *current = current_.load();
+        TransportCatalogue next = current->catalogue;
+        apply(next);
+
+        std::unique_ptr<Version> version;
+        if (next.HasSameStopsAndBuses(current->catalogue))
+        {
+            const auto changed_stops = next.GetChangedDistances(current->catalogue);
+            version = std::make_unique<Version>(current->number + 1, std::move(next), *current, changed_stops, render_settings_, render_pool_);
+        }
+        else
+        {
+            version = std::make_unique<Version>(current->number + 1, std::move(next), render_settings_, router_settings_, render_pool_);
+        }
+        const uint64_t number = version->number;
+        Version *old_version = current_.exchange(version.release());
+
+        // Читатели, вошедшие после увеличения эпохи, гарантированно видят новую версию
+        std::lock_guard retired_lock(retired_mutex_);
+        retired_.push_back({std::unique_ptr<Version>(old_version), global_epoch_.fetch_add(1)});
+        // Счётчик публикуется до проверки ячеек: читатель, вышедший после проверки, увидит его и удалит версию сам
+        retired_count_.store(retired_.size());
+        Reclaim();
+        return number;
+    }
+
+    void VersionedCatalogue::RequestReclaim() const
+    {
+        is_reclaim_requested_.store(true);
+        // Запрос, поставленный, пока другой поток держал мьютекс, либо обработан им, либо виден здесь после его выхода
+        while (is_reclaim_requested_.load())
+        {
+            std::unique_lock lock(retired_mutex_, std::try_to_lock);
+            if (!lock)
+            {
+                return;
+            }
+            while (is_reclaim_requested_.exchange(false))
+            {
+                Reclaim();
+            }
+        }
+    }
+
+    void VersionedCatalogue::Reclaim() const
+    {
+        uint64_t min_active_epoch = std::numeric_limits<uint64_t>::max();
+        for (const auto &slot : reader_slots_)
+        {
+            const uint64_t epoch = slot.epoch.load();
+            if (epoch != 0)
+            {
+                min_active_epoch = std::min(min_active_epoch, epoch);
+            }
+        }
+
+        retired_.erase(std::remove_if(retired_.begin(), retired_.end(), [min_active_epoch](const RetiredVersion &retired)
+                                      { return retired.epoch < min_active_epoch; }),
+                       retired_.end());
+        retired_count_.store(retired_.size());
+    }
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "map_renderer.h"
+#include "request_handler.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace catalogue
+{
+    /*
+     * Справочник, который можно обновлять, не останавливая обработку запросов.
+     * Каждая версия неизменяема и содержит свой справочник, маршрутизатор и обработчик запросов.
+     * Обновление применяется к копии текущего справочника (объекты остановок и маршрутов при этом
+     * не копируются) и публикуется заменой указателя. Читатели не берут блокировок: версия,
+     * полученная через Read, не удаляется, пока жив ReadGuard, — за этим следят эпохи читателей.
+     * Заменённая версия удаляется, как только её покидает последний читатель, а не при следующем обновлении:
+     * каждая версия держит свою таблицу маршрутов, и на больших справочниках это сотни мегабайт.
+     * Если обновление изменило только расстояния, маршрутизатор не строится заново, а пересчитывает затронутые маршруты
+     */
+    class VersionedCatalogue
+    {
+    private:
+        struct Version;
+
+    public:
+        VersionedCatalogue(TransportCatalogue catalogue, renderer::RenderSettings &render_settings, const router::RouterSettings &router_settings, ThreadPool *render_pool = nullptr);
+        ~VersionedCatalogue();
+
+        VersionedCatalogue(const VersionedCatalogue &) = delete;
+        VersionedCatalogue &operator=(const VersionedCatalogue &) = delete;
+
+        // Доступ к версии справочника на время жизни объекта
+        class ReadGuard
+        {
+        public:
+            ~ReadGuard();
+
+            ReadGuard(const ReadGuard &) = delete;
+            ReadGuard &operator=(const ReadGuard &) = delete;
+
+            uint64_t GetNumber() const;
+
+            const TransportCatalogue &GetCatalogue() const;
+
+            RequestHandler &GetHandler() const;
+
+        private:
+            friend class VersionedCatalogue;
+
+            ReadGuard(const VersionedCatalogue &versions, std::atomic<uint64_t> &slot, Version *version);
+
+            const VersionedCatalogue &versions_;
+            std::atomic<uint64_t> &slot_;
+            Version *version_;
+        };
+
+        ReadGuard Read() const;
+
+        // Применяет apply к копии текущего справочника и публикует новую версию, возвращая её номер.
+        // Обновления выполняются по очереди. Если apply выбросит исключение, версия не изменится
+        uint64_t Update(const std::function<void(TransportCatalogue &)> &apply);
+
+    private:
+        // Эпоха, в которую читатель получил версию, или 0, если ячейка свободна
+        struct alignas(64) ReaderSlot
+        {
+            std::atomic<uint64_t> epoch = 0;
+        };
+
+        struct RetiredVersion
+        {
+            std::unique_ptr<Version> version;
+            // Версию могут использовать только читатели, вошедшие не позже этой эпохи
+            uint64_t epoch;
+        };
+
+        static const size_t READER_SLOT_COUNT = 256;
+
+        // Удаляет заменённые версии, которые больше никто не читает. Вызывается под retired_mutex_
+        void Reclaim() const;
+
+        // Вызывается читателем при выходе. Не блокирует: если удалением уже занят другой поток,
+        // он увидит запрос и повторит проверку сам
+        void RequestReclaim() const;
+
+        renderer::RenderSettings &render_settings_;
+        const router::RouterSettings &router_settings_;
+        ThreadPool *render_pool_;
+
+        std::atomic<Version *> current_;
+        std::atomic<uint64_t> global_epoch_ = 1;
+        mutable std::array<ReaderSlot, READER_SLOT_COUNT> reader_slots_;
+
+        std::mutex update_mutex_;
+        mutable std::mutex retired_mutex_;
+        mutable std::vector<RetiredVersion> retired_;
+        // Размер retired_, чтобы читатели без заменённых версий не трогали мьютекс
+        mutable std::atomic<size_t> retired_count_ = 0;
+        mutable std::atomic<bool> is_reclaim_requested_ = false;
+    };
+}